@@ -0,0 +1,311 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+#include "CellPool.h"
+
+namespace {
+
+struct FreeBlock {
+    FreeBlock *next;
+    int size_class;
+};
+
+// blocks freed by other threads are pushed to the remote list of the slab owner, the owner takes them over into its
+// free lists when it runs out of a size class. once the owner has exited, head is set to orphaned and such blocks
+// only drop their reference. references counts the owner thread and the slabs of the owner, it is guarded by
+// slab_mutex
+struct RemoteList {
+    atomic<FreeBlock*> head;
+    int references;
+};
+
+FreeBlock *const orphaned = reinterpret_cast<FreeBlock*>(1);
+
+// references counts the live blocks, the blocks in the free list or the remote list of the owner and one while the
+// owner cuts blocks from the slab. nothing can take a new reference to a slab whose count is 0, so such a slab can
+// be unmapped or handed to another thread at any time
+struct SlabHeader {
+    atomic<long long> references;
+    RemoteList *remote;
+};
+
+SlabHeader *slab_of(void *ptr);
+
+// per thread state. a thread only keeps blocks of its own slabs in its free lists, the references it holds are
+// given back when the thread ends
+struct ThreadCache {
+    FreeBlock *free_lists[CellPool::nr_classes + 1];
+    char *bump_pos;
+    char *bump_end;
+    RemoteList *remote;
+    bool compacting;
+    void drop_free_lists();
+    void drop_bump_slab();
+    bool take_remote_blocks();
+    void drop_remote_blocks(FreeBlock *marker);
+    ~ThreadCache();
+};
+
+// blocks start 64 bytes into the slab, behind the header
+const size_t slab_header_size = 64;
+
+thread_local ThreadCache cache = {};
+
+mutex slab_mutex;
+vector<SlabHeader*> slabs;
+
+void ThreadCache::drop_free_lists() {
+    for (int c = 0; c <= CellPool::nr_classes; c++) {
+        for (FreeBlock *block = free_lists[c]; block != nullptr; block = block->next) {
+            slab_of(block)->references.fetch_sub(1, memory_order_release);
+        }
+        free_lists[c] = nullptr;
+    }
+}
+
+void ThreadCache::drop_bump_slab() {
+    if (bump_pos != nullptr) {
+        slab_of(bump_pos - 1)->references.fetch_sub(1, memory_order_release);
+    }
+    bump_pos = nullptr;
+    bump_end = nullptr;
+}
+
+// move the blocks other threads freed into the free lists, returns false if there were none
+bool ThreadCache::take_remote_blocks() {
+
+    if (remote == nullptr || remote->head.load(memory_order_relaxed) == nullptr) {
+        return false;
+    }
+
+    FreeBlock *block = remote->head.exchange(nullptr, memory_order_acquire);
+    while (block != nullptr) {
+        FreeBlock *next = block->next;
+        block->next = free_lists[block->size_class];
+        free_lists[block->size_class] = block;
+        block = next;
+    }
+    return true;
+}
+
+// empty the remote list without reusing the blocks, marker is what is left in its head (nullptr or orphaned)
+void ThreadCache::drop_remote_blocks(FreeBlock *marker) {
+
+    if (remote == nullptr) {
+        return;
+    }
+
+    FreeBlock *block = remote->head.exchange(marker, memory_order_acquire);
+    while (block != nullptr) {
+        FreeBlock *next = block->next;
+        slab_of(block)->references.fetch_sub(1, memory_order_release);
+        block = next;
+    }
+}
+
+ThreadCache::~ThreadCache() {
+
+    drop_free_lists();
+    drop_bump_slab();
+    drop_remote_blocks(orphaned);
+
+    if (remote != nullptr) {
+        lock_guard<mutex> lock(slab_mutex);
+        if (--remote->references == 0) {
+            delete remote;
+        }
+        remote = nullptr;
+    }
+
+    // the slabs of a finished thread that ran empty are not reused by anyone else
+    CellPool::release_empty_slabs();
+}
+
+SlabHeader *slab_of(void *ptr) {
+    return reinterpret_cast<SlabHeader*>(reinterpret_cast<uintptr_t>(ptr) & ~(static_cast<uintptr_t>(CellPool::slab_size) - 1));
+}
+
+// the slab stops pointing to the remote list of its last owner (slab_mutex held)
+void unlink_remote(SlabHeader *slab) {
+    if (--slab->remote->references == 0) {
+        delete slab->remote;
+    }
+    slab->remote = nullptr;
+}
+
+// a slab for tc to cut blocks from: an empty slab of any thread if there is one, a newly mapped one otherwise.
+// slabs are aligned to their size, so the header of a block is found by masking its address
+SlabHeader *map_slab(ThreadCache &tc) {
+
+    lock_guard<mutex> lock(slab_mutex);
+
+    if (tc.remote == nullptr) {
+        tc.remote = new RemoteList;
+        tc.remote->head = nullptr;
+        tc.remote->references = 1;
+    }
+
+    SlabHeader *slab = nullptr;
+    for (int i = 0; i < slabs.size() && slab == nullptr; i++) {
+        if (slabs[i]->references.load(memory_order_acquire) == 0) {
+            slab = slabs[i];
+            unlink_remote(slab);
+        }
+    }
+
+    if (slab == nullptr) {
+        size_t size = CellPool::slab_size;
+        void *mapping = mmap(nullptr, 2 * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            throw bad_alloc();
+        }
+
+        uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+        uintptr_t aligned = (start + size - 1) & ~(static_cast<uintptr_t>(size) - 1);
+        if (aligned > start) {
+            munmap(mapping, aligned - start);
+        }
+        munmap(reinterpret_cast<void*>(aligned + size), start + size - aligned);
+
+        slab = new (reinterpret_cast<void*>(aligned)) SlabHeader;
+        slabs.push_back(slab);
+    }
+
+    slab->references = 1;       // the owner cuts blocks from it
+    slab->remote = tc.remote;
+    tc.remote->references++;
+
+    return slab;
+}
+
+}
+
+void *CellPool::allocate(size_t bytes) {
+
+    int size_class = (bytes + granularity - 1) / granularity;
+    if (size_class == 0) {
+        size_class = 1;
+    }
+    if (size_class > nr_classes) {
+        return ::operator new(bytes);
+    }
+
+    ThreadCache &tc = cache;
+
+    // reuse a freed block of the same class, freed by this thread or by another one
+    if (!tc.compacting) {
+        if (tc.free_lists[size_class] == nullptr) {
+            tc.take_remote_blocks();
+        }
+        FreeBlock *block = tc.free_lists[size_class];
+        if (block != nullptr) {
+            tc.free_lists[size_class] = block->next;
+            return block;
+        }
+    }
+
+    // otherwise cut it from the current slab (the rest of a full slab is wasted, at most 2 KB)
+    size_t size = size_class * granularity;
+    if (tc.bump_pos == nullptr || tc.bump_pos + size > tc.bump_end) {
+        tc.drop_bump_slab();
+        char *slab = reinterpret_cast<char*>(map_slab(tc));
+        tc.bump_pos = slab + slab_header_size;
+        tc.bump_end = slab + slab_size;
+    }
+
+    void *ptr = tc.bump_pos;
+    tc.bump_pos += size;
+    slab_of(ptr)->references.fetch_add(1, memory_order_relaxed);
+
+    return ptr;
+}
+
+void CellPool::deallocate(void *ptr, size_t bytes) {
+
+    if (ptr == nullptr) {
+        return;
+    }
+
+    int size_class = (bytes + granularity - 1) / granularity;
+    if (size_class == 0) {
+        size_class = 1;
+    }
+    if (size_class > nr_classes) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    // own blocks go to the free list of this thread, blocks freed while compacting are not reused. the free lists
+    // of a thread are never touched by another one
+    ThreadCache &tc = cache;
+    SlabHeader *slab = slab_of(ptr);
+    FreeBlock *block = static_cast<FreeBlock*>(ptr);
+    if (slab->remote == tc.remote) {
+        if (tc.compacting) {
+            slab->references.fetch_sub(1, memory_order_release);
+        } else {
+            block->next = tc.free_lists[size_class];
+            tc.free_lists[size_class] = block;
+        }
+        return;
+    }
+
+    // blocks of other threads' slabs go to the remote list of their owner, unless the owner has exited
+    block->size_class = size_class;
+    RemoteList *remote = slab->remote;
+    FreeBlock *head = remote->head.load(memory_order_relaxed);
+    do {
+        if (head == orphaned) {
+            slab->references.fetch_sub(1, memory_order_release);
+            return;
+        }
+        block->next = head;
+    } while (!remote->head.compare_exchange_weak(head, block, memory_order_release, memory_order_relaxed));
+}
+
+// start on a fresh slab so the compacted arrays do not mix with older blocks. the free lists of this thread are
+// dropped, so the slabs of the build run empty while the cells are copied
+void CellPool::begin_compaction() {
+
+    ThreadCache &tc = cache;
+    tc.drop_free_lists();
+    tc.drop_remote_blocks(nullptr);
+    tc.drop_bump_slab();
+    tc.compacting = true;
+}
+
+void CellPool::end_compaction() {
+    cache.compacting = false;
+}
+
+// unmap all slabs that no thread references any more (no live blocks, no free blocks, not cut from), returns the
+// number of bytes given back. safe while other threads allocate and free
+long long CellPool::release_empty_slabs() {
+
+    lock_guard<mutex> lock(slab_mutex);
+
+    int nr_released = 0;
+    vector<SlabHeader*> kept;
+    kept.reserve(slabs.size());
+    for (int i = 0; i < slabs.size(); i++) {
+        if (slabs[i]->references.load(memory_order_acquire) == 0) {
+            unlink_remote(slabs[i]);
+            munmap(slabs[i], slab_size);
+            nr_released++;
+        } else {
+            kept.push_back(slabs[i]);
+        }
+    }
+    slabs.swap(kept);
+
+    return static_cast<long long>(nr_released) * slab_size;
+}
+
+long long CellPool::get_reserved_bytes() {
+
+    lock_guard<mutex> lock(slab_mutex);
+    return static_cast<long long>(slabs.size()) * slab_size;
+}
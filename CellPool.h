@@ -0,0 +1,67 @@
+#include <cstddef>
+#include <memory>
+using namespace std;
+
+#ifndef CellPool_h
+#define CellPool_h
+
+// slab allocator for the small edge and vertex arrays of the cells. requests are rounded up to 32 byte size classes
+// and cut from 256 KB slabs without any per block header. every slab belongs to the thread that cut it: blocks freed
+// by that thread go to its free list, blocks freed by other threads to a lock free remote list of the owner, which
+// the owner takes over when a size class runs out. both are handed out again for the same size class. blocks of a
+// thread that has exited are not reused, its slabs run empty and are then given to the next thread needing a slab
+// (or unmapped). arrays larger than 2 KB are left to operator new.
+// during a compaction all blocks are cut from fresh slabs one after the other (free lists are not used), so the
+// arrays copied in cell order end up contiguous. release_empty_slabs() gives slabs back to the system that no thread
+// references any more (no live blocks, no blocks in a free list, not the slab blocks are cut from), so it can be
+// called while other threads use the pool. it runs after every build and whenever a thread ends, and every few
+// thousand cells of a compaction, which keeps the old and the new copy from being mapped at the same time.
+class CellPool {
+
+public:
+    static const size_t granularity = 32;
+    static const int nr_classes = 64;
+    static const size_t slab_size = 256 * 1024;
+    static void *allocate(size_t bytes);
+    static void deallocate(void *ptr, size_t bytes);
+    static void begin_compaction();
+    static void end_compaction();
+    static long long release_empty_slabs();
+    static long long get_reserved_bytes();
+
+};
+
+#ifdef VMP_CELL_POOL
+
+template <class T>
+struct CellAllocator {
+
+    typedef T value_type;
+
+    CellAllocator() noexcept {}
+    template <class U> CellAllocator(const CellAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        return static_cast<T*>(CellPool::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t n) noexcept {
+        CellPool::deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template <class T, class U>
+bool operator==(const CellAllocator<T> &, const CellAllocator<U> &) { return true; }
+
+template <class T, class U>
+bool operator!=(const CellAllocator<T> &, const CellAllocator<U> &) { return false; }
+
+#else
+
+// pool switched off at configure time: plain heap allocations
+template <class T>
+using CellAllocator = allocator<T>;
+
+#endif
+
+#endif
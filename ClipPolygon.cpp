@@ -0,0 +1,119 @@
+#include <algorithm>
+#include "ClipPolygon.h"
+
+ClipPolygon::ClipPolygon() {
+    nr_verticies = 0;
+}
+
+ClipPolygon::~ClipPolygon() {}
+
+// start again as the unit square of a new seed: top, right, bottom and left boundary (clockwise)
+void ClipPolygon::reset(Point seed, int index) {
+
+    this->seed = seed;
+    this->index = index;
+    nr_verticies = 4;
+
+    for (int i = 0; i < 4; i++) {
+        edges[i] = VoronoiCell::get_boundary_halfplane(-2 - i);
+        sites[i] = make_mirror_site(seed, -2 - i);
+    }
+    for (int i = 0; i < 4; i++) {
+        verticies[i] = get_vertex(edges[i], edges[(i+1)%4]);
+    }
+}
+
+// cut off the part of the polygon that is closer to other_seed. the verticies in conflict with the new seed are one
+// run (the polygon is convex), they are replaced by the bisector and its two intersections with the edges around.
+// false if the polygon has no room for another vertex, then it is left unchanged
+bool ClipPolygon::clip(Point other_seed, int other_index) {
+
+    int n = nr_verticies;
+    PredicateSite cell_site = make_site(seed, index);
+    PredicateSite new_site = make_site(other_seed, other_index);
+
+    bool in_conflict[VMP_MAX_CLIP_VERTICES];
+    for (int i = 0; i < n; i++) {
+        in_conflict[i] = incircle_sign_perturbed(cell_site, sites[i], sites[(i+1)%n], new_site) < 0;
+    }
+
+    // first vertex of the run: in conflict, the one before is not
+    int first = -1;
+    for (int i = 0; i < n && first < 0; i++) {
+        if (in_conflict[i] && !in_conflict[(i+n-1)%n]) {
+            first = i;
+        }
+    }
+    if (first < 0) {
+        return true;
+    }
+    int last = first;
+    while (in_conflict[(last+1)%n]) {
+        last = (last+1)%n;
+    }
+
+    int nr_removed = (last - first + n)%n + 1;
+    if (n - nr_removed + 2 > VMP_MAX_CLIP_VERTICES) {
+        return false;
+    }
+
+    // start the polygon at the run, then vertex 0 is cut on edge 0 and the new edge follows edge 0
+    if (first > 0) {
+        rotate(edges, edges + first, edges + n);
+        rotate(sites, sites + first, sites + n);
+        rotate(verticies, verticies + first, verticies + n);
+    }
+
+    Halfplane new_edge(seed, other_seed, index, other_index);
+    Point first_vertex = get_vertex(edges[0], new_edge);
+    Point second_vertex = get_vertex(new_edge, edges[nr_removed]);
+
+    // the kept edges and verticies nr_removed to n-1 move to 2 and up
+    if (nr_removed > 2) {
+        move(edges + nr_removed, edges + n, edges + 2);
+        move(sites + nr_removed, sites + n, sites + 2);
+        move(verticies + nr_removed, verticies + n, verticies + 2);
+    } else if (nr_removed == 1) {
+        move_backward(edges + 1, edges + n, edges + n + 1);
+        move_backward(sites + 1, sites + n, sites + n + 1);
+        move_backward(verticies + 1, verticies + n, verticies + n + 1);
+    }
+
+    edges[1] = new_edge;
+    sites[1] = new_site;
+    verticies[0] = first_vertex;
+    verticies[1] = second_vertex;
+    nr_verticies = n - nr_removed + 2;
+    return true;
+}
+
+// squared distance between the seed and the farthest vertex: a seed further away than twice that can not clip
+double ClipPolygon::get_security_radius_squared() {
+
+    double max_dist_squared = 0;
+    for (int i = 0; i < nr_verticies; i++) {
+        double dx = verticies[i].x - seed.x;
+        double dy = verticies[i].y - seed.y;
+        max_dist_squared = max(max_dist_squared, dx*dx + dy*dy);
+    }
+    return max_dist_squared;
+}
+
+void ClipPolygon::copy_to_cell(VoronoiCell &vcell) {
+    vcell.edges.assign(edges, edges + nr_verticies);
+    vcell.verticies.assign(verticies, verticies + nr_verticies);
+}
+
+// intersection of two edges (same arithmetic as VoronoiCell::intersect_two_halfplanes)
+Point ClipPolygon::get_vertex(const Halfplane &hp1, const Halfplane &hp2) {
+
+    double D = hp1.hp_vec.x * hp2.hp_vec.y - hp1.hp_vec.y * hp2.hp_vec.x;
+    double Dx = (hp2.midpoint.x - hp1.midpoint.x) * hp2.hp_vec.y -
+                (hp2.midpoint.y - hp1.midpoint.y) * hp2.hp_vec.x;
+    if (D == 0) {
+        return hp1.midpoint;
+    }
+
+    double x = Dx/D;
+    return Point(hp1.midpoint.x + x*hp1.hp_vec.x, hp1.midpoint.y + x*hp1.hp_vec.y);
+}
@@ -0,0 +1,39 @@
+#include <vector>
+#include "Point.h"
+#include "Halfplane.h"
+#include "RobustPredicates.h"
+#include "VoronoiCell.h"
+using namespace std;
+
+#ifndef ClipPolygon_h
+#define ClipPolygon_h
+
+// most edges a clipped cell can have before the builder falls back to construct_cell_local
+#define VMP_MAX_CLIP_VERTICES 64
+
+// cell of one seed as a convex polygon of fixed size (lives on the stack and is reset for every cell, no allocations)
+// that starts as the unit square and is clipped by the bisectors to other seeds one after another. clockwise like
+// VoronoiCell: vertex i lies between edge i and edge i+1. which verticies a seed cuts off is decided exactly with the
+// same perturbed incircle test as in the point insertion, so the clipping order does not change the result
+class ClipPolygon {
+
+public:
+    ClipPolygon();
+    ~ClipPolygon();
+    void reset(Point seed, int index);
+    Point seed;
+    int index;
+    int nr_verticies;
+    Halfplane edges[VMP_MAX_CLIP_VERTICES];
+    Point verticies[VMP_MAX_CLIP_VERTICES];
+    bool clip(Point other_seed, int other_index);
+    double get_security_radius_squared();
+    void copy_to_cell(VoronoiCell &vcell);
+
+private:
+    PredicateSite sites[VMP_MAX_CLIP_VERTICES];     // site of every edge for the predicates
+    Point get_vertex(const Halfplane &hp1, const Halfplane &hp2);
+
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include "CompactMesh.h"
+#include "MappedMesh.h"
+
+CompactMesh::CompactMesh() {
+    cell_offsets.push_back(0);
+}
+
+// convert a finished mesh, vertices shared by several cells are stored only once
+CompactMesh::CompactMesh(const VoronoiMesh &vmesh) {
+    assign(vmesh);
+    vertices.shrink_to_fit();
+}
+
+CompactMesh::~CompactMesh() {}
+
+// convert a finished mesh into the arrays, they keep their capacity so converting every timestep does not allocate
+void CompactMesh::assign(const VoronoiMesh &vmesh) {
+
+    int n = vmesh.vcells.size();
+
+    vertices.clear();
+    seeds.resize(n);
+    cell_offsets.resize(n + 1);
+    cell_offsets[0] = 0;
+    for (int i = 0; i < n; i++) {
+        seeds[i] = vmesh.vcells[i].seed;
+        cell_offsets[i + 1] = cell_offsets[i] + vmesh.vcells[i].verticies.size();
+    }
+
+    cell_vertices.resize(cell_offsets[n]);
+    cell_neighbours.resize(cell_offsets[n]);
+
+    // first pass: a vertex belongs to the cell with the smallest index among the (up to) three cells meeting there
+    for (int i = 0; i < n; i++) {
+
+        const VoronoiCell &cell = vmesh.vcells[i];
+        int m = cell.edges.size();
+
+        for (int j = 0; j < m; j++) {
+
+            int neighbour1 = cell.edges[j].index2;
+            int neighbour2 = cell.edges[(j + 1) % m].index2;
+            cell_neighbours[cell_offsets[i] + j] = neighbour1;
+
+            bool owner = (neighbour1 < 0 || i < neighbour1) && (neighbour2 < 0 || i < neighbour2);
+            if (owner) {
+                cell_vertices[cell_offsets[i] + j] = vertices.size();
+                vertices.push_back(cell.verticies[j]);
+            } else {
+                cell_vertices[cell_offsets[i] + j] = -1;
+            }
+        }
+    }
+
+    // second pass: look up the vertices owned by other cells
+    for (int i = 0; i < n; i++) {
+
+        const VoronoiCell &cell = vmesh.vcells[i];
+        int m = cell.edges.size();
+
+        for (int j = 0; j < m; j++) {
+
+            if (cell_vertices[cell_offsets[i] + j] >= 0) {
+                continue;
+            }
+
+            int neighbour1 = cell.edges[j].index2;
+            int neighbour2 = cell.edges[(j + 1) % m].index2;
+
+            // owner is the smallest non negative index, the other two are the cells it has to share the vertex with
+            int owner = neighbour1;
+            if (neighbour2 >= 0 && (owner < 0 || neighbour2 < owner)) {
+                owner = neighbour2;
+            }
+            int other = (owner == neighbour1) ? neighbour2 : neighbour1;
+
+            int id = find_shared_vertex(vmesh.vcells[owner], owner, i, other);
+
+            // degenerate vertices (more than three cells) are not shared, just store them again
+            if (id < 0) {
+                id = vertices.size();
+                vertices.push_back(cell.verticies[j]);
+            }
+            cell_vertices[cell_offsets[i] + j] = id;
+        }
+    }
+}
+
+// returns the global id of the vertex of owner that lies between its edges to neighbour1 and neighbour2 (-1 if none)
+int CompactMesh::find_shared_vertex(const VoronoiCell &owner, int owner_index, int neighbour1, int neighbour2) {
+
+    int m = owner.edges.size();
+
+    for (int k = 0; k < m; k++) {
+
+        int a = owner.edges[k].index2;
+        int b = owner.edges[(k + 1) % m].index2;
+
+        if ((a == neighbour1 && b == neighbour2) || (a == neighbour2 && b == neighbour1)) {
+            return cell_vertices[cell_offsets[owner_index] + k];
+        }
+    }
+
+    return -1;
+}
+
+int CompactMesh::get_nr_cells() const {
+    return seeds.size();
+}
+
+// memory of the flat arrays (no per cell allocations)
+long long CompactMesh::calculate_mesh_memory(bool use_capacity) const {
+
+    long long total_size;
+    if (use_capacity) {
+        total_size = sizeof(CompactMesh) + sizeof(Point)*(seeds.capacity() + vertices.capacity())
+                   + sizeof(int)*(cell_offsets.capacity() + cell_vertices.capacity() + cell_neighbours.capacity());
+    } else {
+        total_size = sizeof(CompactMesh) + sizeof(Point)*(seeds.size() + vertices.size())
+                   + sizeof(int)*(cell_offsets.size() + cell_vertices.size() + cell_neighbours.size());
+    }
+
+    return total_size;
+}
+
+// bytes of the mesh as binary mesh file (header, arrays and the padding between them)
+long long CompactMesh::get_binary_size() const {
+
+    auto align = [](long long size) { return (size + 7) & ~7LL; };
+
+    long long total = align(sizeof(BinaryMeshHeader));
+    total += align(sizeof(Point) * seeds.size());
+    total += align(sizeof(Point) * vertices.size());
+    total += align(sizeof(int) * cell_offsets.size());
+    total += align(sizeof(int) * cell_vertices.size());
+    total += sizeof(int) * cell_neighbours.size();
+
+    return total;
+}
+
+// write the mesh in the binary format described in MappedMesh.h, the arrays are written as they are in memory
+bool CompactMesh::save_mesh_to_binary(string filename) {
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        cout << "could not open " << filename << " for writing" << endl;
+        return false;
+    }
+
+    // all sections start 8 byte aligned
+    auto align = [](uint64_t offset) { return (offset + 7) & ~static_cast<uint64_t>(7); };
+
+    BinaryMeshHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MESH_MAGIC, 8);
+    header.version = BINARY_MESH_VERSION;
+    header.index_size = sizeof(int);
+    header.nr_cells = seeds.size();
+    header.nr_vertices = vertices.size();
+    header.nr_cell_entries = cell_vertices.size();
+    header.seeds_offset = align(sizeof(BinaryMeshHeader));
+    header.vertices_offset = align(header.seeds_offset + sizeof(Point) * seeds.size());
+    header.cell_offsets_offset = align(header.vertices_offset + sizeof(Point) * vertices.size());
+    header.cell_vertices_offset = align(header.cell_offsets_offset + sizeof(int) * cell_offsets.size());
+    header.cell_neighbours_offset = align(header.cell_vertices_offset + sizeof(int) * cell_vertices.size());
+
+    // write a section after padding up to its offset
+    uint64_t position = 0;
+    auto write_section = [&](uint64_t offset, const void *section, uint64_t size) {
+        static const char padding[8] = {0};
+        fwrite(padding, 1, offset - position, file);
+        fwrite(section, 1, size, file);
+        position = offset + size;
+    };
+
+    write_section(0, &header, sizeof(header));
+    write_section(header.seeds_offset, seeds.data(), sizeof(Point) * seeds.size());
+    write_section(header.vertices_offset, vertices.data(), sizeof(Point) * vertices.size());
+    write_section(header.cell_offsets_offset, cell_offsets.data(), sizeof(int) * cell_offsets.size());
+    write_section(header.cell_vertices_offset, cell_vertices.data(), sizeof(int) * cell_vertices.size());
+    write_section(header.cell_neighbours_offset, cell_neighbours.data(), sizeof(int) * cell_neighbours.size());
+
+    bool success = (ferror(file) == 0);
+    fclose(file);
+
+    return success;
+}
+
+// the same three csv files as VoronoiMesh::save_mesh_to_files (seeds, the vertices of every cell, the edges of every cell)
+void CompactMesh::save_mesh_to_files(int nr, bool compress) {
+
+    int n = get_nr_cells();
+
+    ostringstream seed_list;
+    seed_list << "seed_x,seed_y";
+    for (int i = 0; i < n; i++) {
+        seed_list << "\n" << seeds[i].x << "," << seeds[i].y;
+    }
+    write_mesh_file("files/seed_list" + to_string(nr) + ".csv", seed_list.str(), compress);
+
+    ostringstream vertex_list;
+    vertex_list << "vertex_x,vertex_y";
+    for (int i = 0; i < n; i++) {
+        for (int j = cell_offsets[i]; j < cell_offsets[i + 1]; j++) {
+            const Point &v = vertices[cell_vertices[j]];
+            vertex_list << "\n" << v.x << "," << v.y;
+        }
+    }
+    write_mesh_file("files/vertex_list" + to_string(nr) + ".csv", vertex_list.str(), compress);
+
+    ostringstream edge_list;
+    edge_list << "edge1_x, edge1_y, edge2_x, edge2_y";
+    for (int i = 0; i < n; i++) {
+        int begin = cell_offsets[i];
+        int m = cell_offsets[i + 1] - begin;
+        for (int j = 0; j < m; j++) {
+            const Point &v1 = vertices[cell_vertices[begin + j]];
+            const Point &v2 = vertices[cell_vertices[begin + (j + 1) % m]];
+            edge_list << "\n" << v1.x << "," << v1.y << "," << v2.x << "," << v2.y;
+        }
+    }
+    write_mesh_file("files/edge_list" + to_string(nr) + ".csv", edge_list.str(), compress);
+}
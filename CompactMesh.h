@@ -0,0 +1,36 @@
+#include <vector>
+#include <string>
+#include "Point.h"
+#include "VoronoiMesh.h"
+using namespace std;
+
+#ifndef CompactMesh_h
+#define CompactMesh_h
+
+// flat structure of arrays mesh: cell i has the vertices cell_vertices[cell_offsets[i]..cell_offsets[i+1])
+// and the neighbours cell_neighbours[cell_offsets[i]..cell_offsets[i+1]) (negative: boundary -2..-5).
+// neighbour j shares the edge that ends in vertex j, just like edges[j] and verticies[j] of a VoronoiCell.
+class CompactMesh {
+
+public:
+    CompactMesh();
+    CompactMesh(const VoronoiMesh &vmesh);
+    ~CompactMesh();
+    vector<Point> seeds;
+    vector<Point> vertices;
+    vector<int> cell_offsets;
+    vector<int> cell_vertices;
+    vector<int> cell_neighbours;
+    void assign(const VoronoiMesh &vmesh);
+    int get_nr_cells() const;
+    long long calculate_mesh_memory(bool use_capacity) const;
+    long long get_binary_size() const;
+    bool save_mesh_to_binary(string filename);
+    void save_mesh_to_files(int nr, bool compress = false);
+
+private:
+    int find_shared_vertex(const VoronoiCell &owner, int owner_index, int neighbour1, int neighbour2);
+
+};
+
+#endif
@@ -0,0 +1,358 @@
+#include <cmath>
+#include <algorithm>
+#include "DelaunayTriangulation.h"
+#include "HintGrid.h"
+
+// the large triangle around the unit square and all mirror images (counterclockwise)
+static const Point outer_verticies[3] = {Point(-50, -50), Point(100, -50), Point(-50, 100)};
+
+// a circumcenter closer than this to a boundary counts as over it (mirroring a seed too often does no harm)
+static const double boundary_margin = 1e-6;
+
+// triangulate the seeds in the given order (a permutation of 0 to n-1), then mirror them at the boundaries
+DelaunayTriangulation::DelaunayTriangulation(const vector<Point> &pts, const vector<int> &order, MeshStats *stats) {
+
+    this->stats = (stats != nullptr) ? stats : &no_stats;
+    nr_seeds = pts.size();
+    total_steps = 0;
+    max_steps = 0;
+    mark_generation = 0;
+    walk_random = 42;
+
+    VMP_STAT_TIMER_START(triangulation_timer);
+#ifdef VMP_ENABLE_STATS
+    long long exact_predicates_before = get_exact_predicate_count();
+#endif
+
+    // the seeds keep their index as vertex and as rank of the symbolic perturbation
+    sites.reserve(nr_seeds + 3);
+    for (int i = 0; i < nr_seeds; i++) {
+        add_vertex(make_site(pts[i], i), i);
+    }
+    for (int k = 0; k < 3; k++) {
+        add_vertex(make_site(outer_verticies[k], -6 - k), -1);
+    }
+
+    int first = new_triangle();
+    for (int k = 0; k < 3; k++) {
+        triangles[first].verticies[k] = nr_seeds + k;
+        triangles[first].neighbours[k] = -1;
+        vertex_triangle[nr_seeds + k] = first;
+    }
+
+    // the walks start at the seed inserted last into the bucket of the new seed (see HintGrid)
+    HintGrid hint_grid(nr_seeds);
+    int last_vertex = nr_seeds;
+    for (int k = 0; k < order.size(); k++) {
+        int v = order[k];
+        int hint = hint_grid.get_hint(pts[v]);
+        int start = vertex_triangle[(hint >= 0) ? hint : last_vertex];
+        if (insert_vertex(v, start)) {
+            hint_grid.add_point(pts[v], v);
+            last_vertex = v;
+            VMP_STAT_ADD(*this->stats, inserts, 1);
+        }
+    }
+
+    // which seeds need mirror images is decided on the triangulation of the seeds alone, the mirror images never
+    // change the cells inside of the unit square except for the boundary edges of their own seed
+    vector<int> mirrors;
+    for (int k = 0; k < order.size(); k++) {
+        int seed = order[k];
+        if (!is_inserted(seed)) {
+            continue;
+        }
+        bool mirrored[4];
+        mark_boundary_mirrors(seed, mirrored);
+        for (int b = 0; b < 4; b++) {
+            if (mirrored[b]) {
+                mirrors.push_back(seed);
+                mirrors.push_back(-2 - b);
+            }
+        }
+    }
+
+    for (int m = 0; m < mirrors.size(); m += 2) {
+        int seed = mirrors[m];
+        int boundary_index = mirrors[m + 1];
+        PredicateSite site = make_mirror_site(pts[seed], boundary_index);
+        site.rank = -9 - 4 * seed + boundary_index + 2;
+        add_vertex(site, seed);
+        insert_vertex(sites.size() - 1, vertex_triangle[seed]);
+    }
+
+    VMP_STAT_ADD(*this->stats, walk_steps, total_steps);
+    VMP_STAT_MAX(*this->stats, max_walk_steps, max_steps);
+    VMP_STAT_ADD(*this->stats, exact_predicates, get_exact_predicate_count() - exact_predicates_before);
+    VMP_STAT_TIMER_STOP(*this->stats, triangulation_time, triangulation_timer);
+
+    // only needed while inserting
+    vector<int>().swap(triangle_marks);
+    vector<int>().swap(fan_start);
+}
+
+DelaunayTriangulation::~DelaunayTriangulation() {}
+
+void DelaunayTriangulation::add_vertex(PredicateSite site, int owner) {
+    sites.push_back(site);
+    mirror_owner.push_back(owner);
+    vertex_triangle.push_back(-1);
+    fan_start.push_back(-1);
+}
+
+int DelaunayTriangulation::new_triangle() {
+
+    if (!free_triangles.empty()) {
+        int t = free_triangles.back();
+        free_triangles.pop_back();
+        return t;
+    }
+
+    triangles.push_back(DelaunayTriangle());
+    triangle_marks.push_back(0);
+    return triangles.size() - 1;
+}
+
+// replace the neighbour of triangle t across its edge between verticies a and b
+void DelaunayTriangulation::set_neighbour(int t, int a, int b, int neighbour) {
+
+    DelaunayTriangle &tri = triangles[t];
+    for (int k = 0; k < 3; k++) {
+        if (tri.verticies[k] != a && tri.verticies[k] != b) {
+            tri.neighbours[k] = neighbour;
+            return;
+        }
+    }
+}
+
+// is vertex v strictly inside the circumcircle of triangle t (cocircular ones decided by the perturbation)?
+bool DelaunayTriangulation::in_conflict(int t, int v) {
+
+    const DelaunayTriangle &tri = triangles[t];
+    return incircle_sign_perturbed(sites[tri.verticies[0]], sites[tri.verticies[1]], sites[tri.verticies[2]], sites[v]) > 0;
+}
+
+// walk from start_triangle to the triangle containing vertex v, always crossing an edge that v lies behind. the edge
+// to test first is picked at random, which keeps the walk from cycling around degenerate configurations
+int DelaunayTriangulation::locate(int v, int start_triangle) {
+
+    int t = start_triangle;
+    int previous = -1;
+    int steps = 0;
+
+    while (true) {
+        steps += 1;
+        const DelaunayTriangle &tri = triangles[t];
+        walk_random = walk_random * 1103515245u + 12345u;
+        int first = (walk_random >> 16) % 3;
+
+        int next = -1;
+        for (int j = 0; j < 3; j++) {
+            int k = (first + j) % 3;
+            int neighbour = tri.neighbours[k];
+            if (neighbour < 0 || neighbour == previous) {
+                continue;
+            }
+            if (orient2d_sign(sites[tri.verticies[(k+1)%3]], sites[tri.verticies[(k+2)%3]], sites[v]) < 0) {
+                next = neighbour;
+                break;
+            }
+        }
+
+        if (next < 0) {
+            break;
+        }
+        previous = t;
+        t = next;
+    }
+
+    total_steps += steps;
+    max_steps = max(max_steps, steps);
+    return t;
+}
+
+// Bowyer-Watson: remove all triangles whose circumcircle contains the vertex and connect the vertex to the edges of
+// the hole. false (and nothing changed) if the vertex lies on top of an inserted one, i.e. a seed placed twice
+bool DelaunayTriangulation::insert_vertex(int v, int start_triangle) {
+
+    int t = locate(v, start_triangle);
+
+    for (int k = 0; k < 3; k++) {
+        const PredicateSite &other = sites[triangles[t].verticies[k]];
+        if (other.mirror == sites[v].mirror && other.pt.x == sites[v].pt.x && other.pt.y == sites[v].pt.y) {
+            return false;
+        }
+    }
+
+    // the triangle containing v is in conflict, all others of the hole are connected to it through triangles in
+    // conflict. every neighbour is tested once: mark_generation for the hole, mark_generation + 1 for the rest
+    mark_generation += 2;
+    cavity.clear();
+    cavity_edges.clear();
+    cavity.push_back(t);
+    triangle_marks[t] = mark_generation;
+
+    for (int c = 0; c < cavity.size(); c++) {
+        int inside = cavity[c];
+        for (int k = 0; k < 3; k++) {
+            int outside = triangles[inside].neighbours[k];
+            if (outside >= 0 && triangle_marks[outside] == mark_generation) {
+                continue;
+            }
+            if (outside >= 0 && triangle_marks[outside] != mark_generation + 1) {
+                if (in_conflict(outside, v)) {
+                    triangle_marks[outside] = mark_generation;
+                    cavity.push_back(outside);
+                    continue;
+                }
+                triangle_marks[outside] = mark_generation + 1;
+            }
+
+            // edge of the hole, counterclockwise seen from inside
+            cavity_edges.push_back(triangles[inside].verticies[(k+1)%3]);
+            cavity_edges.push_back(triangles[inside].verticies[(k+2)%3]);
+            cavity_edges.push_back(outside);
+        }
+    }
+
+    for (int c = 0; c < cavity.size(); c++) {
+        free_triangles.push_back(cavity[c]);
+    }
+
+    // one new triangle per edge of the hole, fan_start of the first vertex of an edge is its new triangle
+    int first_new = -1;
+    for (int e = 0; e < cavity_edges.size(); e += 3) {
+        int a = cavity_edges[e];
+        int b = cavity_edges[e + 1];
+        int outside = cavity_edges[e + 2];
+
+        int nt = new_triangle();
+        DelaunayTriangle &tri = triangles[nt];
+        tri.verticies[0] = a;
+        tri.verticies[1] = b;
+        tri.verticies[2] = v;
+        tri.neighbours[2] = outside;
+        if (outside >= 0) {
+            set_neighbour(outside, a, b, nt);
+        }
+        triangle_marks[nt] = 0;
+
+        fan_start[a] = nt;
+        vertex_triangle[a] = nt;
+        vertex_triangle[b] = nt;
+        if (first_new < 0) {
+            first_new = nt;
+        }
+    }
+
+    // neighbours inside of the fan: across the edge b-v lies the triangle starting at b
+    for (int e = 0; e < cavity_edges.size(); e += 3) {
+        int a = cavity_edges[e];
+        int b = cavity_edges[e + 1];
+        int nt = fan_start[a];
+        int next = fan_start[b];
+        triangles[nt].neighbours[0] = next;
+        triangles[next].neighbours[1] = nt;
+    }
+
+    vertex_triangle[v] = first_new;
+    return true;
+}
+
+bool DelaunayTriangulation::is_inserted(int seed) {
+    return vertex_triangle[seed] >= 0;
+}
+
+// at which boundaries does the cell of the seed reach over the unit square? the cell is the polygon of the
+// circumcenters of its triangles (bounded, because of the large triangle around everything). circumcenters of
+// nearly flat triangles are not reliable, then the seed is mirrored at all boundaries
+void DelaunayTriangulation::mark_boundary_mirrors(int seed, bool *mirrored) {
+
+    for (int b = 0; b < 4; b++) {
+        mirrored[b] = false;
+    }
+
+    int t0 = vertex_triangle[seed];
+    int t = t0;
+    do {
+        const DelaunayTriangle &tri = triangles[t];
+        Point a = sites[tri.verticies[0]].pt;
+        Point b = sites[tri.verticies[1]].pt;
+        Point c = sites[tri.verticies[2]].pt;
+
+        double bx = b.x - a.x;
+        double by = b.y - a.y;
+        double cx = c.x - a.x;
+        double cy = c.y - a.y;
+        double b_squared = bx * bx + by * by;
+        double c_squared = cx * cx + cy * cy;
+        double det = 2 * (bx * cy - by * cx);
+
+        if (fabs(det) <= 2e-6 * sqrt(b_squared * c_squared)) {
+            for (int k = 0; k < 4; k++) {
+                mirrored[k] = true;
+            }
+            return;
+        }
+
+        double center_x = a.x + (cy * b_squared - by * c_squared) / det;
+        double center_y = a.y + (bx * c_squared - cx * b_squared) / det;
+        mirrored[0] = mirrored[0] || center_y > 1 - boundary_margin;     // -2: y = 1
+        mirrored[1] = mirrored[1] || center_x > 1 - boundary_margin;     // -3: x = 1
+        mirrored[2] = mirrored[2] || center_y < boundary_margin;         // -4: y = 0
+        mirrored[3] = mirrored[3] || center_x < boundary_margin;         // -5: x = 0
+
+        int i = (tri.verticies[0] == seed) ? 0 : ((tri.verticies[1] == seed) ? 1 : 2);
+        t = tri.neighbours[(i+2)%3];
+    } while (t != t0);
+
+    // a seed right on a boundary would lie on top of its mirror image
+    Point pt = sites[seed].pt;
+    mirrored[0] = mirrored[0] && pt.y != 1;
+    mirrored[1] = mirrored[1] && pt.x != 1;
+    mirrored[2] = mirrored[2] && pt.y != 0;
+    mirrored[3] = mirrored[3] && pt.x != 0;
+}
+
+// the edges of the Voronoi cell of a seed in clockwise order, as index2 of the halfplanes: the index of the
+// neighbouring seed or the boundary index (-2 to -5) for the edges to its own mirror images. edges to mirror
+// images of other seeds have length zero (they only touch the cell at a boundary) and are left out
+void DelaunayTriangulation::get_voronoi_neighbours(int seed, vector<int> &neighbours) {
+
+    neighbours.clear();
+
+    int t0 = vertex_triangle[seed];
+    int t = t0;
+    do {
+        const DelaunayTriangle &tri = triangles[t];
+        int i = (tri.verticies[0] == seed) ? 0 : ((tri.verticies[1] == seed) ? 1 : 2);
+        int neighbour = tri.verticies[(i+1)%3];
+
+        if (neighbour < nr_seeds) {
+            neighbours.push_back(neighbour);
+        } else if (mirror_owner[neighbour] == seed) {
+            neighbours.push_back(sites[neighbour].mirror);
+        }
+
+        // the next triangle clockwise shares the edge to this neighbour
+        t = tri.neighbours[(i+2)%3];
+    } while (t != t0);
+}
+
+long long DelaunayTriangulation::calculate_memory(bool use_capacity) {
+
+    long long total = sizeof(DelaunayTriangulation);
+    if (use_capacity) {
+        total += sites.capacity() * sizeof(PredicateSite);
+        total += (mirror_owner.capacity() + vertex_triangle.capacity() + free_triangles.capacity()) * sizeof(int);
+        total += (triangle_marks.capacity() + cavity.capacity() + cavity_edges.capacity() + fan_start.capacity()) * sizeof(int);
+        total += triangles.capacity() * sizeof(DelaunayTriangle);
+    } else {
+        total += sites.size() * sizeof(PredicateSite);
+        total += (mirror_owner.size() + vertex_triangle.size() + free_triangles.size()) * sizeof(int);
+        total += (triangle_marks.size() + cavity.size() + cavity_edges.size() + fan_start.size()) * sizeof(int);
+        total += triangles.size() * sizeof(DelaunayTriangle);
+    }
+
+    return total;
+}
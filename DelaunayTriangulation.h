@@ -0,0 +1,58 @@
+#include <vector>
+#include "Point.h"
+#include "RobustPredicates.h"
+#include "MeshStats.h"
+using namespace std;
+
+#ifndef DelaunayTriangulation_h
+#define DelaunayTriangulation_h
+
+// counterclockwise triangle, neighbours[k] is the triangle across the edge opposite of verticies[k] (-1 outside)
+struct DelaunayTriangle
+    {
+        int verticies[3];
+        int neighbours[3];
+    };
+
+// Delaunay triangulation of the seeds (Bowyer-Watson) for the dual construction of the Voronoi mesh.
+// verticies 0 to n-1 are the seeds, then the three verticies of a large triangle around everything and the mirror
+// images of the seeds at the boundaries of the unit square. a seed is mirrored at a boundary if its cell reaches
+// over it, then the edges to its own mirror images are the boundary edges of its cell. all decisions are taken
+// with the exact predicates of RobustPredicates.h, cocircular seeds are triangulated by the symbolic perturbation.
+class DelaunayTriangulation {
+
+public:
+    DelaunayTriangulation(const vector<Point> &pts, const vector<int> &order, MeshStats *stats = nullptr);
+    ~DelaunayTriangulation();
+    int nr_seeds;
+    vector<PredicateSite> sites;
+    vector<int> mirror_owner;           // seed of every vertex (-1 for the large triangle)
+    vector<DelaunayTriangle> triangles;
+    vector<int> vertex_triangle;        // one triangle of every vertex, -1 if the vertex was not inserted
+    long long total_steps;
+    int max_steps;
+    bool is_inserted(int seed);
+    void get_voronoi_neighbours(int seed, vector<int> &neighbours);
+    long long calculate_memory(bool use_capacity);
+
+private:
+    MeshStats *stats;
+    MeshStats no_stats;
+    vector<int> free_triangles;
+    vector<int> triangle_marks;
+    int mark_generation;
+    vector<int> cavity;
+    vector<int> cavity_edges;           // both verticies of the edge (counterclockwise) and the triangle outside
+    vector<int> fan_start;
+    unsigned int walk_random;
+    void add_vertex(PredicateSite site, int owner);
+    bool insert_vertex(int v, int start_triangle);
+    int locate(int v, int start_triangle);
+    bool in_conflict(int t, int v);
+    int new_triangle();
+    void set_neighbour(int t, int a, int b, int neighbour);
+    void mark_boundary_mirrors(int seed, bool *mirrored);
+
+};
+
+#endif
@@ -0,0 +1,378 @@
+#include <cmath>
+#include <algorithm>
+#include "FortuneSweep.h"
+#include "RobustPredicates.h"
+
+bool CircleEventOrder::operator()(const CircleEvent &a, const CircleEvent &b) const {
+    return a.y < b.y || (a.y == b.y && a.id > b.id);
+}
+
+// sweep all seeds and collect the pairs of neighbouring cells (the edges of the Delaunay triangulation)
+FortuneSweep::FortuneSweep(const vector<Point> &pts, MeshStats *stats) : pts(pts) {
+
+    this->stats = (stats != nullptr) ? stats : &no_stats;
+    root = -1;
+    random_state = 42;
+    nr_circle_events = 0;
+
+    VMP_STAT_TIMER_START(sweep_timer);
+#ifdef VMP_ENABLE_STATS
+    long long exact_predicates_before = get_exact_predicate_count();
+#endif
+
+    // site events from top to bottom, sites on one horizontal line from left to right
+    int n = pts.size();
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&pts](int i, int j) {
+        return pts[i].y > pts[j].y || (pts[i].y == pts[j].y && (pts[i].x < pts[j].x || (pts[i].x == pts[j].x && i < j)));
+    });
+
+    arcs.reserve(2 * n);
+    pairs.reserve(6 * n);
+
+    int k = 0;
+    while (k < n || !event_queue.empty()) {
+
+        // a circle event at the height of the next site comes first
+        if (!event_queue.empty() && (k == n || event_queue.top().y >= pts[order[k]].y)) {
+            CircleEvent event = event_queue.top();
+            event_queue.pop();
+            if (arcs[event.arc].circle_event == event.id) {
+                handle_circle_event(event.arc);
+            }
+            continue;
+        }
+
+        int site = order[k];
+        if (k > 0 && pts[site].x == pts[order[k-1]].x && pts[site].y == pts[order[k-1]].y) {
+            duplicate_seeds.push_back(site);
+        } else {
+            handle_site_event(site);
+            VMP_STAT_ADD(*this->stats, inserts, 1);
+        }
+        k++;
+    }
+
+    // pairs -> sorted neighbour lists without repetitions
+    neighbour_offsets.assign(n + 1, 0);
+    for (int p = 0; p < pairs.size(); p++) {
+        neighbour_offsets[pairs[p] + 1] += 1;
+    }
+    for (int i = 0; i < n; i++) {
+        neighbour_offsets[i + 1] += neighbour_offsets[i];
+    }
+    neighbours.resize(pairs.size());
+    vector<int> fill_position(neighbour_offsets.begin(), neighbour_offsets.end() - 1);
+    for (int p = 0; p < pairs.size(); p += 2) {
+        neighbours[fill_position[pairs[p]]++] = pairs[p + 1];
+        neighbours[fill_position[pairs[p + 1]]++] = pairs[p];
+    }
+
+    int total = 0;
+    for (int i = 0; i < n; i++) {
+        int begin = neighbour_offsets[i];
+        int end = neighbour_offsets[i + 1];
+        sort(neighbours.begin() + begin, neighbours.begin() + end);
+        neighbour_offsets[i] = total;
+        for (int j = begin; j < end; j++) {
+            if (j == begin || neighbours[j] != neighbours[j - 1]) {
+                neighbours[total++] = neighbours[j];
+            }
+        }
+    }
+    neighbour_offsets[n] = total;
+    neighbours.resize(total);
+
+    // only needed while sweeping
+    vector<int>().swap(pairs);
+    vector<BeachArc>().swap(arcs);
+    vector<int>().swap(free_arcs);
+
+    VMP_STAT_ADD(*this->stats, exact_predicates, get_exact_predicate_count() - exact_predicates_before);
+    VMP_STAT_TIMER_STOP(*this->stats, sweep_time, sweep_timer);
+}
+
+FortuneSweep::~FortuneSweep() {}
+
+int FortuneSweep::new_arc(int site) {
+
+    int a;
+    if (!free_arcs.empty()) {
+        a = free_arcs.back();
+        free_arcs.pop_back();
+    } else {
+        arcs.push_back(BeachArc());
+        a = arcs.size() - 1;
+    }
+
+    random_state = random_state * 1103515245u + 12345u;
+
+    BeachArc &arc = arcs[a];
+    arc.site = site;
+    arc.left = -1;
+    arc.right = -1;
+    arc.parent = -1;
+    arc.prev = -1;
+    arc.next = -1;
+    arc.priority = random_state;
+    arc.circle_event = -1;
+    return a;
+}
+
+void FortuneSweep::release_arc(int a) {
+    arcs[a].circle_event = -1;
+    free_arcs.push_back(a);
+}
+
+// rotate arc a above its parent, the order from left to right stays the same
+void FortuneSweep::rotate_up(int a) {
+
+    int p = arcs[a].parent;
+    int g = arcs[p].parent;
+
+    if (arcs[p].left == a) {
+        arcs[p].left = arcs[a].right;
+        if (arcs[a].right >= 0) {
+            arcs[arcs[a].right].parent = p;
+        }
+        arcs[a].right = p;
+    } else {
+        arcs[p].right = arcs[a].left;
+        if (arcs[a].left >= 0) {
+            arcs[arcs[a].left].parent = p;
+        }
+        arcs[a].left = p;
+    }
+    arcs[p].parent = a;
+    arcs[a].parent = g;
+
+    if (g < 0) {
+        root = a;
+    } else if (arcs[g].left == p) {
+        arcs[g].left = a;
+    } else {
+        arcs[g].right = a;
+    }
+}
+
+// put new_a right of arc a on the beach line
+void FortuneSweep::insert_after(int a, int new_a) {
+
+    int next = arcs[a].next;
+    arcs[new_a].prev = a;
+    arcs[new_a].next = next;
+    if (next >= 0) {
+        arcs[next].prev = new_a;
+    }
+    arcs[a].next = new_a;
+
+    // the position right after a in the tree: right child of a, or left child of its old successor
+    if (arcs[a].right < 0) {
+        arcs[a].right = new_a;
+        arcs[new_a].parent = a;
+    } else {
+        arcs[next].left = new_a;
+        arcs[new_a].parent = next;
+    }
+
+    while (arcs[new_a].parent >= 0 && arcs[arcs[new_a].parent].priority < arcs[new_a].priority) {
+        rotate_up(new_a);
+    }
+}
+
+void FortuneSweep::remove_arc(int a) {
+
+    // rotate down to a leaf
+    while (arcs[a].left >= 0 || arcs[a].right >= 0) {
+        int left = arcs[a].left;
+        int right = arcs[a].right;
+        if (right < 0 || (left >= 0 && arcs[left].priority > arcs[right].priority)) {
+            rotate_up(left);
+        } else {
+            rotate_up(right);
+        }
+    }
+
+    int p = arcs[a].parent;
+    if (p < 0) {
+        root = -1;
+    } else if (arcs[p].left == a) {
+        arcs[p].left = -1;
+    } else {
+        arcs[p].right = -1;
+    }
+
+    int prev = arcs[a].prev;
+    int next = arcs[a].next;
+    if (prev >= 0) {
+        arcs[prev].next = next;
+    }
+    if (next >= 0) {
+        arcs[next].prev = prev;
+    }
+
+    release_arc(a);
+}
+
+// x of the breakpoint between the arc of left_site and the arc of right_site right of it, with the sweepline at
+// sweep_y. the arc of a site on the sweepline is a vertical line through the site
+double FortuneSweep::get_breakpoint(int left_site, int right_site, double sweep_y) {
+
+    Point p = pts[left_site];
+    Point q = pts[right_site];
+    double dp = p.y - sweep_y;
+    double dq = q.y - sweep_y;
+
+    if (dp == 0 && dq == 0) {
+        return 0.5 * (p.x + q.x);
+    }
+    if (dp == 0) {
+        return p.x;
+    }
+    if (dq == 0) {
+        return q.x;
+    }
+    if (p.y == q.y) {
+        return 0.5 * (p.x + q.x);
+    }
+
+    // the parabolas cross where (dq - dp) u^2 + 2 dp qx u + dp (dq (p.y - q.y) - qx^2) = 0, u = x - p.x. of the two
+    // crossings the left one is the breakpoint if p is the higher site (the wider parabola is lower outside)
+    double qx = q.x - p.x;
+    double a = dq - dp;
+    double b = 2 * dp * qx;
+    double c = dp * (dq * (p.y - q.y) - qx * qx);
+    double discriminant = max(b * b - 4 * a * c, 0.0);
+    double t = -0.5 * (b + copysign(sqrt(discriminant), b));
+
+    double u1 = t / a;
+    double u2 = (t != 0) ? c / t : u1;
+    double u = (p.y > q.y) ? min(u1, u2) : max(u1, u2);
+    return p.x + u;
+}
+
+// the arc above pt
+int FortuneSweep::find_arc(Point pt) {
+
+    int a = root;
+    while (true) {
+        const BeachArc &arc = arcs[a];
+        if (arc.left >= 0 && pt.x < get_breakpoint(arcs[arc.prev].site, arc.site, pt.y)) {
+            a = arc.left;
+        } else if (arc.right >= 0 && pt.x > get_breakpoint(arc.site, arcs[arc.next].site, pt.y)) {
+            a = arc.right;
+        } else {
+            return a;
+        }
+    }
+}
+
+void FortuneSweep::add_pair(int site1, int site2) {
+    pairs.push_back(site1);
+    pairs.push_back(site2);
+}
+
+void FortuneSweep::invalidate_circle_event(int a) {
+    arcs[a].circle_event = -1;
+}
+
+// arc a vanishes if the breakpoints to its neighbours converge, i.e. if the three sites turn clockwise. the event is
+// queued even if rounding puts it slightly above the sweepline, then it comes next
+void FortuneSweep::check_circle_event(int a) {
+
+    int prev = arcs[a].prev;
+    int next = arcs[a].next;
+    if (prev < 0 || next < 0) {
+        return;
+    }
+
+    int site_a = arcs[prev].site;
+    int site_b = arcs[a].site;
+    int site_c = arcs[next].site;
+    if (site_a == site_c) {
+        return;
+    }
+    if (orient2d_sign(make_site(pts[site_a], site_a), make_site(pts[site_b], site_b), make_site(pts[site_c], site_c)) >= 0) {
+        return;
+    }
+
+    // circumcenter relative to the middle site
+    double ax = pts[site_a].x - pts[site_b].x;
+    double ay = pts[site_a].y - pts[site_b].y;
+    double cx = pts[site_c].x - pts[site_b].x;
+    double cy = pts[site_c].y - pts[site_b].y;
+    double d = 2 * (ax * cy - ay * cx);
+    if (d == 0) {
+        return;     // nearly collinear: the vertex is too far away to matter
+    }
+    double a_squared = ax * ax + ay * ay;
+    double c_squared = cx * cx + cy * cy;
+    double ux = (cy * a_squared - ay * c_squared) / d;
+    double uy = (ax * c_squared - cx * a_squared) / d;
+
+    CircleEvent event;
+    event.y = pts[site_b].y + uy - sqrt(ux * ux + uy * uy);
+    event.id = nr_circle_events++;
+    event.arc = a;
+    arcs[a].circle_event = event.id;
+    event_queue.push(event);
+}
+
+// the new site splits the arc above it into two, with its own arc in between
+void FortuneSweep::handle_site_event(int site) {
+
+    if (root < 0) {
+        root = new_arc(site);
+        return;
+    }
+
+    int a = find_arc(pts[site]);
+    int split_site = arcs[a].site;
+    add_pair(split_site, site);
+
+    // only on the first line of sites: the arc is a vertical line left of the new site, nothing to split
+    if (pts[split_site].y == pts[site].y) {
+        int new_a = new_arc(site);
+        insert_after(a, new_a);
+        check_circle_event(a);
+        check_circle_event(new_a);
+        return;
+    }
+
+    invalidate_circle_event(a);
+    int new_a = new_arc(site);
+    int right_a = new_arc(split_site);
+    insert_after(a, new_a);
+    insert_after(new_a, right_a);
+    check_circle_event(a);
+    check_circle_event(right_a);
+}
+
+// arc a vanishes in a vertex of the diagram, its neighbours meet
+void FortuneSweep::handle_circle_event(int a) {
+
+    int prev = arcs[a].prev;
+    int next = arcs[a].next;
+    add_pair(arcs[prev].site, arcs[next].site);
+
+    invalidate_circle_event(prev);
+    invalidate_circle_event(next);
+    remove_arc(a);
+    check_circle_event(prev);
+    check_circle_event(next);
+}
+
+long long FortuneSweep::calculate_memory(bool use_capacity) {
+
+    long long total = sizeof(FortuneSweep);
+    if (use_capacity) {
+        total += (neighbour_offsets.capacity() + neighbours.capacity() + duplicate_seeds.capacity()) * sizeof(int);
+    } else {
+        total += (neighbour_offsets.size() + neighbours.size() + duplicate_seeds.size()) * sizeof(int);
+    }
+
+    return total;
+}
@@ -0,0 +1,79 @@
+#include <vector>
+#include <queue>
+#include "Point.h"
+#include "MeshStats.h"
+using namespace std;
+
+#ifndef FortuneSweep_h
+#define FortuneSweep_h
+
+// arc of the beach line: node of a treap (binary search tree ordered from left to right, balanced by random
+// priorities) and of a doubly linked list of its neighbours
+struct BeachArc
+    {
+        int site;
+        int left;
+        int right;
+        int parent;
+        int prev;
+        int next;
+        unsigned int priority;
+        long long circle_event;     // id of the event where the arc vanishes, -1 if there is none (yet)
+    };
+
+// lowest point of the circle through the sites of three neighbouring arcs, the middle arc vanishes there. the event
+// is only valid as long as the arc still carries its id
+struct CircleEvent
+    {
+        double y;
+        long long id;
+        int arc;
+    };
+
+// order of the event queue: highest y first
+struct CircleEventOrder
+    {
+        bool operator()(const CircleEvent &a, const CircleEvent &b) const;
+    };
+
+// Fortune's sweepline algorithm: the line sweeps the seeds from top to bottom, the beach line of parabolas is kept
+// in a balanced tree and the events in a priority queue. every pair of arcs that become neighbours on the beach
+// line is a pair of neighbouring cells, which is all the algorithm keeps (in CSR form). O(nlogn) for any order of
+// the seeds, convergence of the breakpoints is decided with the exact orientation predicate
+class FortuneSweep {
+
+public:
+    FortuneSweep(const vector<Point> &pts, MeshStats *stats = nullptr);
+    ~FortuneSweep();
+    vector<int> neighbour_offsets;      // neighbours of seed i: neighbours[neighbour_offsets[i]] until [i+1]
+    vector<int> neighbours;
+    vector<int> duplicate_seeds;        // seeds placed twice, left out of the sweep
+    long long calculate_memory(bool use_capacity);
+
+private:
+    const vector<Point> &pts;
+    MeshStats *stats;
+    MeshStats no_stats;
+    vector<BeachArc> arcs;
+    vector<int> free_arcs;
+    int root;
+    unsigned int random_state;
+    priority_queue<CircleEvent, vector<CircleEvent>, CircleEventOrder> event_queue;
+    long long nr_circle_events;
+    vector<int> pairs;                  // neighbouring seeds found by the sweep, two entries per pair
+    int new_arc(int site);
+    void release_arc(int a);
+    void rotate_up(int a);
+    void insert_after(int a, int new_a);
+    void remove_arc(int a);
+    int find_arc(Point pt);
+    double get_breakpoint(int left_site, int right_site, double sweep_y);
+    void add_pair(int site1, int site2);
+    void check_circle_event(int a);
+    void invalidate_circle_event(int a);
+    void handle_site_event(int site);
+    void handle_circle_event(int a);
+
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include <limits>
+#include "HalfplaneBatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VMP_X86_KERNELS
+#endif
+
+namespace {
+
+// parameters of the halfplane intersected with the batch
+struct kernel_input {
+    double mid_x;
+    double mid_y;
+    double vec_x;
+    double vec_y;
+    double start_dist;
+    double lower;
+    double upper;
+    double skip1;
+    double skip2;
+};
+
+// smallest and second smallest distance per SIMD lane (padded batch size is a multiple of 4)
+struct lane_minimum {
+    double min1[4];
+    double min2[4];
+    double index[4];
+};
+
+typedef void (*min_kernel)(const HalfplaneBatch &batch, const kernel_input &in, lane_minimum &out);
+
+#ifndef VMP_X86_KERNELS
+
+// plain c++ for other architectures (x86 always has sse2)
+void min_kernel_scalar(const HalfplaneBatch &batch, const kernel_input &in, lane_minimum &out) {
+
+    const double inf = numeric_limits<double>::infinity();
+    double min1 = inf;
+    double min2 = inf;
+    double index = -1;
+
+    for (int j = 0; j < batch.mid_x.size(); j++) {
+
+        double D = in.vec_x * batch.vec_y[j] - in.vec_y * batch.vec_x[j];
+        double Dx = (batch.mid_x[j] - in.mid_x) * batch.vec_y[j] - (batch.mid_y[j] - in.mid_y) * batch.vec_x[j];
+        double rel_dist = Dx / D - in.start_dist;
+
+        // parallel halfplanes give inf or nan and fail the range check
+        bool valid = rel_dist > in.lower && rel_dist < in.upper && batch.index2[j] != in.skip1 && batch.index2[j] != in.skip2;
+        if (!valid) {
+            continue;
+        }
+        if (rel_dist < min1) {
+            min2 = min1;
+            min1 = rel_dist;
+            index = j;
+        } else if (rel_dist < min2) {
+            min2 = rel_dist;
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        out.min1[k] = inf;
+        out.min2[k] = inf;
+        out.index[k] = -1;
+    }
+    out.min1[0] = min1;
+    out.min2[0] = min2;
+    out.index[0] = index;
+}
+
+#endif
+
+#ifdef VMP_X86_KERNELS
+
+// blend for sse2 (no blendv before sse4.1): mask ? b : a
+inline __m128d select_sse2(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a));
+}
+
+void min_kernel_sse2(const HalfplaneBatch &batch, const kernel_input &in, lane_minimum &out) {
+
+    const __m128d inf = _mm_set1_pd(numeric_limits<double>::infinity());
+    const __m128d mx = _mm_set1_pd(in.mid_x);
+    const __m128d my = _mm_set1_pd(in.mid_y);
+    const __m128d vx = _mm_set1_pd(in.vec_x);
+    const __m128d vy = _mm_set1_pd(in.vec_y);
+    const __m128d start = _mm_set1_pd(in.start_dist);
+    const __m128d lower = _mm_set1_pd(in.lower);
+    const __m128d upper = _mm_set1_pd(in.upper);
+    const __m128d skip1 = _mm_set1_pd(in.skip1);
+    const __m128d skip2 = _mm_set1_pd(in.skip2);
+    const __m128d two = _mm_set1_pd(2);
+
+    __m128d min1 = inf;
+    __m128d min2 = inf;
+    __m128d index = _mm_set1_pd(-1);
+    __m128d j_vec = _mm_set_pd(1, 0);
+
+    int n = batch.mid_x.size();
+    for (int j = 0; j < n; j += 2) {
+
+        __m128d px = _mm_loadu_pd(&batch.mid_x[j]);
+        __m128d py = _mm_loadu_pd(&batch.mid_y[j]);
+        __m128d wx = _mm_loadu_pd(&batch.vec_x[j]);
+        __m128d wy = _mm_loadu_pd(&batch.vec_y[j]);
+        __m128d id = _mm_loadu_pd(&batch.index2[j]);
+
+        __m128d D = _mm_sub_pd(_mm_mul_pd(vx, wy), _mm_mul_pd(vy, wx));
+        __m128d Dx = _mm_sub_pd(_mm_mul_pd(_mm_sub_pd(px, mx), wy), _mm_mul_pd(_mm_sub_pd(py, my), wx));
+        __m128d rel_dist = _mm_sub_pd(_mm_div_pd(Dx, D), start);
+
+        __m128d valid = _mm_and_pd(_mm_cmpgt_pd(rel_dist, lower), _mm_cmplt_pd(rel_dist, upper));
+        valid = _mm_and_pd(valid, _mm_and_pd(_mm_cmpneq_pd(id, skip1), _mm_cmpneq_pd(id, skip2)));
+        rel_dist = select_sse2(valid, inf, rel_dist);
+
+        __m128d smaller = _mm_cmplt_pd(rel_dist, min1);
+        min2 = select_sse2(smaller, _mm_min_pd(min2, rel_dist), min1);
+        min1 = select_sse2(smaller, min1, rel_dist);
+        index = select_sse2(smaller, index, j_vec);
+        j_vec = _mm_add_pd(j_vec, two);
+    }
+
+    _mm_storeu_pd(out.min1, min1);
+    _mm_storeu_pd(out.min2, min2);
+    _mm_storeu_pd(out.index, index);
+    for (int k = 2; k < 4; k++) {
+        out.min1[k] = numeric_limits<double>::infinity();
+        out.min2[k] = numeric_limits<double>::infinity();
+        out.index[k] = -1;
+    }
+}
+
+__attribute__((target("avx2")))
+void min_kernel_avx2(const HalfplaneBatch &batch, const kernel_input &in, lane_minimum &out) {
+
+    const __m256d inf = _mm256_set1_pd(numeric_limits<double>::infinity());
+    const __m256d mx = _mm256_set1_pd(in.mid_x);
+    const __m256d my = _mm256_set1_pd(in.mid_y);
+    const __m256d vx = _mm256_set1_pd(in.vec_x);
+    const __m256d vy = _mm256_set1_pd(in.vec_y);
+    const __m256d start = _mm256_set1_pd(in.start_dist);
+    const __m256d lower = _mm256_set1_pd(in.lower);
+    const __m256d upper = _mm256_set1_pd(in.upper);
+    const __m256d skip1 = _mm256_set1_pd(in.skip1);
+    const __m256d skip2 = _mm256_set1_pd(in.skip2);
+    const __m256d four = _mm256_set1_pd(4);
+
+    __m256d min1 = inf;
+    __m256d min2 = inf;
+    __m256d index = _mm256_set1_pd(-1);
+    __m256d j_vec = _mm256_set_pd(3, 2, 1, 0);
+
+    int n = batch.mid_x.size();
+    for (int j = 0; j < n; j += 4) {
+
+        __m256d px = _mm256_loadu_pd(&batch.mid_x[j]);
+        __m256d py = _mm256_loadu_pd(&batch.mid_y[j]);
+        __m256d wx = _mm256_loadu_pd(&batch.vec_x[j]);
+        __m256d wy = _mm256_loadu_pd(&batch.vec_y[j]);
+        __m256d id = _mm256_loadu_pd(&batch.index2[j]);
+
+        // no fma here on purpose: the distances have to be bit identical to the scalar intersection
+        __m256d D = _mm256_sub_pd(_mm256_mul_pd(vx, wy), _mm256_mul_pd(vy, wx));
+        __m256d Dx = _mm256_sub_pd(_mm256_mul_pd(_mm256_sub_pd(px, mx), wy), _mm256_mul_pd(_mm256_sub_pd(py, my), wx));
+        __m256d rel_dist = _mm256_sub_pd(_mm256_div_pd(Dx, D), start);
+
+        __m256d valid = _mm256_and_pd(_mm256_cmp_pd(rel_dist, lower, _CMP_GT_OQ), _mm256_cmp_pd(rel_dist, upper, _CMP_LT_OQ));
+        valid = _mm256_and_pd(valid, _mm256_and_pd(_mm256_cmp_pd(id, skip1, _CMP_NEQ_OQ), _mm256_cmp_pd(id, skip2, _CMP_NEQ_OQ)));
+        rel_dist = _mm256_blendv_pd(inf, rel_dist, valid);
+
+        __m256d smaller = _mm256_cmp_pd(rel_dist, min1, _CMP_LT_OQ);
+        min2 = _mm256_blendv_pd(_mm256_min_pd(min2, rel_dist), min1, smaller);
+        min1 = _mm256_blendv_pd(min1, rel_dist, smaller);
+        index = _mm256_blendv_pd(index, j_vec, smaller);
+        j_vec = _mm256_add_pd(j_vec, four);
+    }
+
+    _mm256_storeu_pd(out.min1, min1);
+    _mm256_storeu_pd(out.min2, min2);
+    _mm256_storeu_pd(out.index, index);
+}
+
+#endif
+
+struct kernel_choice {
+    min_kernel kernel;
+    const char *name;
+};
+
+kernel_choice select_kernel() {
+#ifdef VMP_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {min_kernel_avx2, "avx2"};
+    }
+    return {min_kernel_sse2, "sse2"};
+#else
+    return {min_kernel_scalar, "scalar"};
+#endif
+}
+
+const kernel_choice active_kernel = select_kernel();
+
+}
+
+HalfplaneBatch::HalfplaneBatch() {
+    size = 0;
+}
+
+HalfplaneBatch::~HalfplaneBatch() {}
+
+// copy the halfplanes into the arrays, the vectors keep their capacity so refilling does not allocate
+void HalfplaneBatch::assign(const Halfplane *hps, int n) {
+
+    size = n;
+    int padded = (n + 3) & ~3;
+
+    mid_x.resize(padded);
+    mid_y.resize(padded);
+    vec_x.resize(padded);
+    vec_y.resize(padded);
+    index2.resize(padded);
+
+    for (int i = 0; i < n; i++) {
+        mid_x[i] = hps[i].midpoint.x;
+        mid_y[i] = hps[i].midpoint.y;
+        vec_x[i] = hps[i].hp_vec.x;
+        vec_y[i] = hps[i].hp_vec.y;
+        index2[i] = hps[i].index2;
+    }
+
+    // zero vectors: the determinant is 0 and the distance nan, so padding is never selected
+    for (int i = n; i < padded; i++) {
+        mid_x[i] = 0;
+        mid_y[i] = 0;
+        vec_x[i] = 0;
+        vec_y[i] = 0;
+        index2[i] = 0;
+    }
+}
+
+// intersect hp with all halfplanes of the batch and return the one with the smallest distance d - start_dist
+// in (lower, upper), d measured from hp.midpoint along hp.hp_vec. halfplanes with index2 equal to one of the skip
+// indices are ignored. ties are not resolved here: second_rel_dist tells the caller whether it has to.
+batch_intersection HalfplaneBatch::find_smallest_pos_intersect(const Halfplane &hp, double start_dist, double lower, double upper,
+                                                               int skip_index1, int skip_index2) const {
+
+    kernel_input in = {hp.midpoint.x, hp.midpoint.y, hp.hp_vec.x, hp.hp_vec.y, start_dist, lower, upper,
+                       static_cast<double>(skip_index1), static_cast<double>(skip_index2)};
+    lane_minimum lanes;
+    active_kernel.kernel(*this, in, lanes);
+
+    // combine the lanes: smallest of all, second smallest is the best other lane or the runner up in that lane
+    int best = 0;
+    for (int k = 1; k < 4; k++) {
+        if (lanes.min1[k] < lanes.min1[best] || (lanes.min1[k] == lanes.min1[best] && lanes.index[k] < lanes.index[best])) {
+            best = k;
+        }
+    }
+    double second = lanes.min2[best];
+    for (int k = 0; k < 4; k++) {
+        if (k != best && lanes.min1[k] < second) {
+            second = lanes.min1[k];
+        }
+    }
+
+    batch_intersection result;
+    result.index = (lanes.min1[best] < numeric_limits<double>::infinity()) ? static_cast<int>(lanes.index[best]) : -1;
+    result.rel_dist = lanes.min1[best];
+    result.second_rel_dist = second;
+
+    // intersection point exactly as in VoronoiCell::intersect_two_halfplanes
+    if (result.index >= 0) {
+        int j = result.index;
+        double D = hp.hp_vec.x * vec_y[j] - hp.hp_vec.y * vec_x[j];
+        double Dx = (mid_x[j] - hp.midpoint.x) * vec_y[j] - (mid_y[j] - hp.midpoint.y) * vec_x[j];
+        double x = Dx/D;
+        result.intersect_pt = Point(hp.midpoint.x + x*hp.hp_vec.x, hp.midpoint.y + x*hp.hp_vec.y);
+    }
+
+    return result;
+}
+
+const char *HalfplaneBatch::get_kernel_name() {
+    return active_kernel.name;
+}
@@ -0,0 +1,40 @@
+#include <vector>
+#include "Point.h"
+#include "Halfplane.h"
+using namespace std;
+
+#ifndef HalfplaneBatch_h
+#define HalfplaneBatch_h
+
+// result of intersecting one halfplane with a whole batch
+struct batch_intersection
+    {
+        int index;                  // position of the closest intersecting halfplane in the batch (-1: none)
+        double rel_dist;            // its signed distance along hp_vec, relative to the start distance
+        double second_rel_dist;     // next distance of any other halfplane (equal to rel_dist for ties, infinity if none)
+        Point intersect_pt;
+    };
+
+// structure of arrays copy of a list of halfplanes, padded to a multiple of 4 with entries that never intersect.
+// one halfplane is intersected with the whole batch in a single pass by a SIMD kernel (avx2, sse2 or scalar, chosen
+// at startup from the cpu features). the determinants and distances are computed with exactly the same operations
+// as in VoronoiCell::intersect_two_halfplanes, but only the smallest and second smallest valid distance are kept.
+class HalfplaneBatch {
+
+public:
+    HalfplaneBatch();
+    ~HalfplaneBatch();
+    int size;
+    vector<double> mid_x;
+    vector<double> mid_y;
+    vector<double> vec_x;
+    vector<double> vec_y;
+    vector<double> index2;
+    void assign(const Halfplane *hps, int n);
+    batch_intersection find_smallest_pos_intersect(const Halfplane &hp, double start_dist, double lower, double upper,
+                                                   int skip_index1, int skip_index2) const;
+    static const char *get_kernel_name();
+
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "HintGrid.h"
+
+HintGrid::HintGrid() {
+    nr_levels = 0;
+}
+
+// the finest level gets about 2 seeds per bucket once all expected seeds are inserted
+HintGrid::HintGrid(int expected_pts) {
+
+    nr_levels = 1;
+    while (nr_levels < 14 && (1LL << (2 * (nr_levels - 1))) * 2 < expected_pts) {
+        nr_levels += 1;
+    }
+
+    levels.resize(nr_levels);
+    for (int l = 0; l < nr_levels; l++) {
+        levels[l].assign(1 << (2 * l), -1);
+    }
+}
+
+HintGrid::~HintGrid() {}
+
+int HintGrid::get_bucket(Point pt, int level) const {
+
+    int size = 1 << level;
+    int bx = static_cast<int>(pt.x * size);
+    int by = static_cast<int>(pt.y * size);
+    bx = (bx < 0) ? 0 : ((bx >= size) ? size - 1 : bx);
+    by = (by < 0) ? 0 : ((by >= size) ? size - 1 : by);
+
+    return by * size + bx;
+}
+
+void HintGrid::add_point(Point pt, int index) {
+
+    for (int l = 0; l < nr_levels; l++) {
+        levels[l][get_bucket(pt, l)] = index;
+    }
+}
+
+// index of an inserted seed near pt (-1 if nothing was inserted yet)
+int HintGrid::get_hint(Point pt) const {
+
+    for (int l = nr_levels - 1; l >= 0; l--) {
+        int index = levels[l][get_bucket(pt, l)];
+        if (index >= 0) {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+bool HintGrid::empty() const {
+    return nr_levels == 0 || levels[0][0] < 0;
+}
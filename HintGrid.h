@@ -0,0 +1,28 @@
+#include <vector>
+#include "Point.h"
+using namespace std;
+
+#ifndef HintGrid_h
+#define HintGrid_h
+
+// grid of the seeds inserted so far that gives the point location walk a start cell close to the new seed.
+// level l has 2^l x 2^l buckets and keeps the seed inserted last into each bucket. the finest level with a seed
+// in the bucket of the point is used, so early on (when fine buckets are still empty) coarse levels give the hint.
+class HintGrid {
+
+public:
+    HintGrid();
+    HintGrid(int expected_pts);
+    ~HintGrid();
+    int nr_levels;
+    vector<vector<int>> levels;
+    void add_point(Point pt, int index);
+    int get_hint(Point pt) const;
+    bool empty() const;
+
+private:
+    int get_bucket(Point pt, int level) const;
+
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include <queue>
+#include <algorithm>
+#include <cstring>
+#include "HuffmanCoder.h"
+
+HuffmanCoder::HuffmanCoder() {
+    memset(code_lengths, 0, sizeof(code_lengths));
+    memset(codes, 0, sizeof(codes));
+}
+
+HuffmanCoder::~HuffmanCoder() {}
+
+// code lengths of the Huffman tree of the counts. if the tree gets deeper than HUFFMAN_MAX_CODE_LENGTH the counts are
+// halved (rare symbols keep a count of 1) and the tree is built again
+void HuffmanCoder::get_code_lengths(const uint64_t *counts) {
+
+    uint64_t weights[256];
+    memcpy(weights, counts, sizeof(weights));
+
+    while (true) {
+
+        // leaves 0 to 255, inner nodes from 256 on
+        int parent[511];
+        priority_queue<pair<uint64_t, int>, vector<pair<uint64_t, int>>, greater<pair<uint64_t, int>>> nodes;
+        for (int s = 0; s < 256; s++) {
+            if (weights[s] > 0) {
+                nodes.push(make_pair(weights[s], s));
+            }
+        }
+
+        memset(code_lengths, 0, sizeof(code_lengths));
+        if (nodes.empty()) {
+            return;
+        }
+        if (nodes.size() == 1) {
+            code_lengths[nodes.top().second] = 1;
+            return;
+        }
+
+        int next_node = 256;
+        while (nodes.size() > 1) {
+            pair<uint64_t, int> a = nodes.top();
+            nodes.pop();
+            pair<uint64_t, int> b = nodes.top();
+            nodes.pop();
+            parent[a.second] = next_node;
+            parent[b.second] = next_node;
+            nodes.push(make_pair(a.first + b.first, next_node));
+            next_node++;
+        }
+
+        // the root is the last inner node, inner nodes are numbered after their children
+        int depth[511];
+        depth[next_node - 1] = 0;
+        for (int node = next_node - 2; node >= 256; node--) {
+            depth[node] = depth[parent[node]] + 1;
+        }
+
+        int max_length = 0;
+        for (int s = 0; s < 256; s++) {
+            if (weights[s] > 0) {
+                code_lengths[s] = depth[parent[s]] + 1;
+                max_length = max(max_length, static_cast<int>(code_lengths[s]));
+            }
+        }
+        if (max_length <= HUFFMAN_MAX_CODE_LENGTH) {
+            return;
+        }
+
+        for (int s = 0; s < 256; s++) {
+            if (weights[s] > 0) {
+                weights[s] = (weights[s] >> 1) | 1;
+            }
+        }
+    }
+}
+
+// codes of the same length are consecutive numbers in the order of the symbols, shorter codes come first
+void HuffmanCoder::get_canonical_codes() {
+
+    uint32_t code = 0;
+    for (int length = 1; length <= HUFFMAN_MAX_CODE_LENGTH; length++) {
+        for (int s = 0; s < 256; s++) {
+            if (code_lengths[s] == length) {
+                codes[s] = code;
+                code++;
+            }
+        }
+        code <<= 1;
+    }
+}
+
+void HuffmanCoder::encode(const vector<uint8_t> &symbols, vector<uint8_t> &block) {
+
+    uint64_t counts[256] = {0};
+    for (size_t i = 0; i < symbols.size(); i++) {
+        counts[symbols[i]] += 1;
+    }
+    get_code_lengths(counts);
+    get_canonical_codes();
+
+    block.clear();
+    uint64_t nr_symbols = symbols.size();
+    for (int b = 0; b < 8; b++) {
+        block.push_back(static_cast<uint8_t>(nr_symbols >> (8 * b)));
+    }
+    for (int s = 0; s < 256; s += 2) {
+        block.push_back(static_cast<uint8_t>(code_lengths[s] | (code_lengths[s + 1] << 4)));
+    }
+
+    // the codes go into the low end of a 64 bit buffer, full bytes leave it at the high end
+    uint64_t buffer = 0;
+    int nr_bits = 0;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        uint8_t s = symbols[i];
+        buffer = (buffer << code_lengths[s]) | codes[s];
+        nr_bits += code_lengths[s];
+        while (nr_bits >= 8) {
+            nr_bits -= 8;
+            block.push_back(static_cast<uint8_t>(buffer >> nr_bits));
+        }
+    }
+    if (nr_bits > 0) {
+        block.push_back(static_cast<uint8_t>(buffer << (8 - nr_bits)));
+    }
+}
+
+// false if the block is cut short or its code lengths do not form a prefix code
+bool HuffmanCoder::decode(const uint8_t *block, size_t block_size, vector<uint8_t> &symbols) {
+
+    if (block_size < 8 + 128) {
+        return false;
+    }
+    uint64_t nr_symbols = 0;
+    for (int b = 0; b < 8; b++) {
+        nr_symbols |= static_cast<uint64_t>(block[b]) << (8 * b);
+    }
+    for (int s = 0; s < 256; s += 2) {
+        code_lengths[s] = block[8 + s/2] & 15;
+        code_lengths[s + 1] = block[8 + s/2] >> 4;
+    }
+    get_canonical_codes();
+
+    // every code fills the table entries of all bit patterns it is a prefix of
+    const int table_size = 1 << HUFFMAN_MAX_CODE_LENGTH;
+    decode_table.assign(table_size, 0);
+    long long filled = 0;
+    for (int s = 0; s < 256; s++) {
+        int length = code_lengths[s];
+        if (length == 0) {
+            continue;
+        }
+        int shift = HUFFMAN_MAX_CODE_LENGTH - length;
+        long long first = static_cast<long long>(codes[s]) << shift;
+        long long last = first + (1LL << shift);
+        if (last > table_size) {
+            return false;
+        }
+        for (long long e = first; e < last; e++) {
+            decode_table[e] = static_cast<uint16_t>(s | (length << 8));
+        }
+        filled += last - first;
+    }
+    if (nr_symbols > 0 && filled == 0) {
+        return false;
+    }
+
+    const uint8_t *bits = block + 8 + 128;
+    size_t nr_bytes = block_size - 8 - 128;
+    if (nr_symbols > 8 * nr_bytes) {
+        return false;
+    }
+    symbols.resize(nr_symbols);
+
+    uint64_t buffer = 0;
+    int nr_bits = 0;
+    size_t position = 0;
+    for (uint64_t i = 0; i < nr_symbols; i++) {
+
+        // past the end the stream is padded with zeros
+        while (nr_bits < HUFFMAN_MAX_CODE_LENGTH) {
+            uint64_t next = (position < nr_bytes) ? bits[position] : 0;
+            position++;
+            buffer = (buffer << 8) | next;
+            nr_bits += 8;
+        }
+
+        uint16_t entry = decode_table[(buffer >> (nr_bits - HUFFMAN_MAX_CODE_LENGTH)) & (table_size - 1)];
+        int length = entry >> 8;
+        if (length == 0) {
+            return false;
+        }
+        symbols[i] = static_cast<uint8_t>(entry & 255);
+        nr_bits -= length;
+    }
+
+    return position <= nr_bytes + 2;
+}
@@ -0,0 +1,32 @@
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+#ifndef HuffmanCoder_h
+#define HuffmanCoder_h
+
+// longest code, the decoder looks codes up in a table of 2^HUFFMAN_MAX_CODE_LENGTH entries
+#define HUFFMAN_MAX_CODE_LENGTH 15
+
+// canonical Huffman code of a byte stream. an encoded block is
+//   uint64 number of bytes, 128 bytes of code lengths (4 bits per byte value), the codes (most significant bit first)
+// the coder keeps its buffers, so encoding stream after stream does not allocate
+class HuffmanCoder {
+
+public:
+    HuffmanCoder();
+    ~HuffmanCoder();
+    void encode(const vector<uint8_t> &symbols, vector<uint8_t> &block);
+    bool decode(const uint8_t *block, size_t block_size, vector<uint8_t> &symbols);
+
+private:
+    uint8_t code_lengths[256];
+    uint32_t codes[256];
+    vector<uint16_t> decode_table;      // next HUFFMAN_MAX_CODE_LENGTH bits -> symbol | code length << 8
+    void get_code_lengths(const uint64_t *counts);
+    void get_canonical_codes();
+
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "MappedMesh.h"
+
+MappedMesh::MappedMesh() {
+    header = nullptr;
+    seeds = nullptr;
+    vertices = nullptr;
+    cell_offsets = nullptr;
+    cell_vertices = nullptr;
+    cell_neighbours = nullptr;
+    data = nullptr;
+    data_size = 0;
+}
+
+MappedMesh::~MappedMesh() {
+    close();
+}
+
+// map the file into memory and point the arrays into it, returns false if the file is not a valid mesh file
+bool MappedMesh::open(string filename) {
+
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cout << "could not open mesh file " << filename << endl;
+        return false;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || sb.st_size < sizeof(BinaryMeshHeader)) {
+        cout << "mesh file " << filename << " is too small" << endl;
+        ::close(fd);
+        return false;
+    }
+
+    data_size = sb.st_size;
+    data = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        cout << "could not mmap mesh file " << filename << endl;
+        return false;
+    }
+
+    header = static_cast<const BinaryMeshHeader*>(data);
+    if (memcmp(header->magic, BINARY_MESH_MAGIC, 8) != 0 || header->version != BINARY_MESH_VERSION ||
+        (header->index_size != 4 && header->index_size != 8)) {
+        cout << "mesh file " << filename << " has an unknown format or version" << endl;
+        close();
+        return false;
+    }
+
+    // every section has to be 8 byte aligned and lie completely inside the file (truncated or corrupted files)
+    uint64_t index_size = header->index_size;
+    if (header->nr_cells == UINT64_MAX ||
+        !section_fits(header->seeds_offset, header->nr_cells, sizeof(Point)) ||
+        !section_fits(header->vertices_offset, header->nr_vertices, sizeof(Point)) ||
+        !section_fits(header->cell_offsets_offset, header->nr_cells + 1, index_size) ||
+        !section_fits(header->cell_vertices_offset, header->nr_cell_entries, index_size) ||
+        !section_fits(header->cell_neighbours_offset, header->nr_cell_entries, index_size)) {
+        cout << "mesh file " << filename << " is truncated or corrupted" << endl;
+        close();
+        return false;
+    }
+
+    const char *base = static_cast<const char*>(data);
+    seeds = reinterpret_cast<const Point*>(base + header->seeds_offset);
+    vertices = reinterpret_cast<const Point*>(base + header->vertices_offset);
+    cell_offsets = base + header->cell_offsets_offset;
+    cell_vertices = base + header->cell_vertices_offset;
+    cell_neighbours = base + header->cell_neighbours_offset;
+
+    // the cell offsets have to cover exactly the entries of the file
+    if (get_offset(0) != 0 || get_offset(header->nr_cells) != static_cast<long long>(header->nr_cell_entries)) {
+        cout << "mesh file " << filename << " has inconsistent cell offsets" << endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// does an array of count elements of elem_size bytes at offset fit into the mapped file (without overflows)
+bool MappedMesh::section_fits(uint64_t offset, uint64_t count, uint64_t elem_size) const {
+
+    if (offset < sizeof(BinaryMeshHeader) || offset % 8 != 0 || offset > data_size) {
+        return false;
+    }
+    return count <= (data_size - offset) / elem_size;
+}
+
+void MappedMesh::close() {
+
+    if (data != nullptr) {
+        munmap(data, data_size);
+    }
+    data = nullptr;
+    data_size = 0;
+    header = nullptr;
+    seeds = nullptr;
+    vertices = nullptr;
+    cell_offsets = nullptr;
+    cell_vertices = nullptr;
+    cell_neighbours = nullptr;
+}
+
+long long MappedMesh::get_index(const void *array, long long i) const {
+
+    if (header->index_size == 4) {
+        return static_cast<const int32_t*>(array)[i];
+    }
+    return static_cast<const int64_t*>(array)[i];
+}
+
+long long MappedMesh::get_offset(long long i) const {
+    return get_index(cell_offsets, i);
+}
+
+long long MappedMesh::get_vertex(long long i) const {
+    return get_index(cell_vertices, i);
+}
+
+long long MappedMesh::get_neighbour(long long i) const {
+    return get_index(cell_neighbours, i);
+}
@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "Point.h"
+using namespace std;
+
+#ifndef MappedMesh_h
+#define MappedMesh_h
+
+// binary mesh file (.vmsh): header followed by 8 byte aligned little endian arrays
+//   seeds           nr_cells x (double x, double y)
+//   vertices        nr_vertices x (double x, double y)
+//   cell_offsets    nr_cells+1 x index
+//   cell_vertices   nr_cell_entries x index
+//   cell_neighbours nr_cell_entries x index (negative: boundary -2..-5)
+// index is int32 or int64 (index_size), offsets in the header are byte offsets from the start of the file
+struct BinaryMeshHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t index_size;
+    uint64_t nr_cells;
+    uint64_t nr_vertices;
+    uint64_t nr_cell_entries;
+    uint64_t seeds_offset;
+    uint64_t vertices_offset;
+    uint64_t cell_offsets_offset;
+    uint64_t cell_vertices_offset;
+    uint64_t cell_neighbours_offset;
+};
+
+const char BINARY_MESH_MAGIC[8] = {'V', 'M', 'P', 'M', 'E', 'S', 'H', '\0'};
+const uint32_t BINARY_MESH_VERSION = 1;
+
+// read only view of a binary mesh file through mmap, the arrays are used in place without parsing. open checks the
+// header and that every section lies inside the file, the indices stored in the arrays are not checked
+class MappedMesh {
+
+public:
+    MappedMesh();
+    ~MappedMesh();
+    bool open(string filename);
+    void close();
+    const BinaryMeshHeader *header;
+    const Point *seeds;
+    const Point *vertices;
+    const void *cell_offsets;
+    const void *cell_vertices;
+    const void *cell_neighbours;
+    long long get_offset(long long i) const;
+    long long get_vertex(long long i) const;
+    long long get_neighbour(long long i) const;
+
+private:
+    void *data;
+    size_t data_size;
+    long long get_index(const void *array, long long i) const;
+    bool section_fits(uint64_t offset, uint64_t count, uint64_t elem_size) const;
+
+};
+
+#endif
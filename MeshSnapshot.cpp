@@ -0,0 +1,334 @@
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "MeshSnapshot.h"
+#include "SpaceFillingCurve.h"
+
+// small signed numbers -> small unsigned numbers: 0, -1, 1, -2, 2, ...
+static uint64_t zigzag_encode(long long value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static long long zigzag_decode(uint64_t value) {
+    return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+}
+
+// 7 bits per byte, the high bit says that more bytes follow
+static void put_varint(vector<uint8_t> &stream, uint64_t value) {
+    while (value >= 128) {
+        stream.push_back(static_cast<uint8_t>(value | 128));
+        value >>= 7;
+    }
+    stream.push_back(static_cast<uint8_t>(value));
+}
+
+static bool get_varint(const vector<uint8_t> &stream, size_t &position, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= stream.size()) {
+            return false;
+        }
+        uint8_t byte = stream[position++];
+        value |= static_cast<uint64_t>(byte & 127) << shift;
+        if (byte < 128) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MeshSnapshot::MeshSnapshot(int bits) {
+    this->bits = bits;
+    report = snapshot_report{0, 0, 0};
+}
+
+MeshSnapshot::~MeshSnapshot() {}
+
+// largest difference between a coordinate and its value after the round trip (half a quantization step)
+double MeshSnapshot::get_error_bound() const {
+    return 0.5 / static_cast<double>((1LL << bits) - 1);
+}
+
+long long MeshSnapshot::quantize(double x) const {
+    x = min(max(x, 0.0), 1.0);
+    return llround(x * static_cast<double>((1LL << bits) - 1));
+}
+
+double MeshSnapshot::dequantize(long long q) const {
+    return static_cast<double>(q) / static_cast<double>((1LL << bits) - 1);
+}
+
+bool MeshSnapshot::save(const CompactMesh &cmesh, string filename) {
+
+    auto start = chrono::high_resolution_clock::now();
+
+    int n = cmesh.get_nr_cells();
+    vector<uint64_t> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = get_hilbert_key(cmesh.seeds[i]);
+    }
+    vector<int> order = radix_sort_keys(keys);
+    vector<int> position(n);
+    for (int p = 0; p < n; p++) {
+        position[order[p]] = p;
+    }
+
+    for (int s = 0; s < SNAPSHOT_NR_STREAMS; s++) {
+        streams[s].clear();
+    }
+
+    // verticies are numbered in the order they are first seen along the curve, neighbouring cells see them close together
+    vector<long long> new_ids(cmesh.vertices.size(), -1);
+    long long next_id = 0;
+    long long last_index = 0;
+    long long last_x = 0;
+    long long last_y = 0;
+
+    for (int p = 0; p < n; p++) {
+
+        int i = order[p];
+        long long x = quantize(cmesh.seeds[i].x);
+        long long y = quantize(cmesh.seeds[i].y);
+        put_varint(streams[0], zigzag_encode(i - last_index));
+        put_varint(streams[1], zigzag_encode(x - last_x));
+        put_varint(streams[2], zigzag_encode(y - last_y));
+        put_varint(streams[3], cmesh.cell_offsets[i + 1] - cmesh.cell_offsets[i]);
+        last_index = i;
+        last_x = x;
+        last_y = y;
+
+        for (int k = cmesh.cell_offsets[i]; k < cmesh.cell_offsets[i + 1]; k++) {
+
+            int neighbour = cmesh.cell_neighbours[k];
+            if (neighbour < -5 || neighbour >= n) {
+                cout << "snapshot: cell " << i << " has the invalid neighbour " << neighbour << endl;
+                return false;
+            }
+            if (neighbour < 0) {
+                put_varint(streams[4], -neighbour - 2);
+            } else {
+                put_varint(streams[4], 4 + zigzag_encode(static_cast<long long>(position[neighbour]) - p));
+            }
+
+            int v = cmesh.cell_vertices[k];
+            if (new_ids[v] < 0) {
+                new_ids[v] = next_id++;
+                put_varint(streams[5], 0);
+                put_varint(streams[6], zigzag_encode(quantize(cmesh.vertices[v].x) - x));
+                put_varint(streams[7], zigzag_encode(quantize(cmesh.vertices[v].y) - y));
+            } else {
+                put_varint(streams[5], next_id - new_ids[v]);
+            }
+        }
+    }
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        cout << "could not open " << filename << " for writing" << endl;
+        return false;
+    }
+
+    // the header is written again at the end, when the sizes of the coded streams are known
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, 8);
+    header.version = SNAPSHOT_VERSION;
+    header.bits = bits;
+    header.nr_cells = n;
+    header.nr_vertices = next_id;
+    header.nr_cell_entries = cmesh.cell_vertices.size();
+    fwrite(&header, 1, sizeof(header), file);
+
+    long long total = sizeof(header);
+    for (int s = 0; s < SNAPSHOT_NR_STREAMS; s++) {
+        coder.encode(streams[s], block);
+        fwrite(block.data(), 1, block.size(), file);
+        header.stream_sizes[s] = block.size();
+        total += block.size();
+    }
+
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, 1, sizeof(header), file);
+
+    bool success = (ferror(file) == 0);
+    fclose(file);
+
+    auto end = chrono::high_resolution_clock::now();
+    report.raw_bytes = cmesh.get_binary_size();
+    report.compressed_bytes = total;
+    report.seconds = chrono::duration<double>(end - start).count();
+
+    return success;
+}
+
+// read a snapshot back into cmesh (cells in their original order). false if the file is not a valid snapshot
+bool MeshSnapshot::load(string filename, CompactMesh &cmesh) {
+
+    auto start = chrono::high_resolution_clock::now();
+
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == nullptr) {
+        cout << "could not open " << filename << " for reading" << endl;
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    vector<uint8_t> data(max(file_size, 0L));
+    bool read_ok = file_size > 0 && fread(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+
+    SnapshotHeader header;
+    if (!read_ok || data.size() < sizeof(header)) {
+        cout << filename << " is not a mesh snapshot" << endl;
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, 8) != 0 || header.version != SNAPSHOT_VERSION || header.bits < 1 || header.bits > 32
+        || header.nr_cells > 2147483647ull || header.nr_cell_entries > 2147483647ull || header.nr_vertices > header.nr_cell_entries) {
+        cout << filename << " is not a mesh snapshot of a supported version" << endl;
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    for (int s = 0; s < SNAPSHOT_NR_STREAMS; s++) {
+        if (header.stream_sizes[s] > data.size() - offset || !coder.decode(data.data() + offset, header.stream_sizes[s], streams[s])) {
+            cout << filename << ": stream " << s << " is damaged" << endl;
+            return false;
+        }
+        offset += header.stream_sizes[s];
+    }
+    vector<uint8_t>().swap(data);
+
+    bits = header.bits;
+    int n = header.nr_cells;
+    size_t positions[SNAPSHOT_NR_STREAMS] = {0};
+    uint64_t value;
+
+    // first the cells (streams 0 to 3), their degrees give the offsets in the original order
+    vector<int> order(n);
+    vector<long long> seed_x(n);
+    vector<long long> seed_y(n);
+    vector<char> seen(n, 0);
+    cmesh.seeds.resize(n);
+    cmesh.cell_offsets.assign(n + 1, 0);
+    long long last_index = 0;
+    long long last_x = 0;
+    long long last_y = 0;
+
+    for (int p = 0; p < n; p++) {
+
+        bool ok = get_varint(streams[0], positions[0], value);
+        long long i = last_index + zigzag_decode(value);
+        ok = ok && get_varint(streams[1], positions[1], value);
+        long long x = last_x + zigzag_decode(value);
+        ok = ok && get_varint(streams[2], positions[2], value);
+        long long y = last_y + zigzag_decode(value);
+        ok = ok && get_varint(streams[3], positions[3], value);
+        if (!ok || i < 0 || i >= n || seen[i] || value > header.nr_cell_entries) {
+            cout << filename << ": cell " << p << " is damaged" << endl;
+            return false;
+        }
+
+        seen[i] = 1;
+        order[p] = i;
+        seed_x[p] = x;
+        seed_y[p] = y;
+        cmesh.seeds[i] = Point(dequantize(x), dequantize(y));
+        cmesh.cell_offsets[i + 1] = value;
+        last_index = i;
+        last_x = x;
+        last_y = y;
+    }
+
+    for (int i = 0; i < n; i++) {
+        cmesh.cell_offsets[i + 1] += cmesh.cell_offsets[i];
+    }
+    if (static_cast<uint64_t>(cmesh.cell_offsets[n]) != header.nr_cell_entries) {
+        cout << filename << ": the cell degrees do not add up" << endl;
+        return false;
+    }
+
+    // then the neighbours and verticies of every cell (streams 4 to 7)
+    cmesh.cell_neighbours.resize(header.nr_cell_entries);
+    cmesh.cell_vertices.resize(header.nr_cell_entries);
+    cmesh.vertices.resize(header.nr_vertices);
+    long long next_id = 0;
+
+    for (int p = 0; p < n; p++) {
+
+        int i = order[p];
+        for (int k = cmesh.cell_offsets[i]; k < cmesh.cell_offsets[i + 1]; k++) {
+
+            bool ok = get_varint(streams[4], positions[4], value);
+            long long neighbour;
+            if (value < 4) {
+                neighbour = -static_cast<long long>(value) - 2;
+            } else {
+                long long neighbour_position = p + zigzag_decode(value - 4);
+                ok = ok && neighbour_position >= 0 && neighbour_position < n;
+                neighbour = ok ? order[neighbour_position] : -1;
+            }
+
+            ok = ok && get_varint(streams[5], positions[5], value);
+            long long id;
+            if (ok && value == 0) {
+                id = next_id++;
+                ok = id < static_cast<long long>(header.nr_vertices) && get_varint(streams[6], positions[6], value);
+                long long x = seed_x[p] + zigzag_decode(value);
+                ok = ok && get_varint(streams[7], positions[7], value);
+                long long y = seed_y[p] + zigzag_decode(value);
+                if (ok) {
+                    cmesh.vertices[id] = Point(dequantize(x), dequantize(y));
+                }
+            } else {
+                id = next_id - static_cast<long long>(value);
+                ok = ok && value <= static_cast<uint64_t>(next_id);
+            }
+
+            if (!ok) {
+                cout << filename << ": cell " << i << " is damaged" << endl;
+                return false;
+            }
+            cmesh.cell_neighbours[k] = neighbour;
+            cmesh.cell_vertices[k] = id;
+        }
+    }
+
+    if (next_id != static_cast<long long>(header.nr_vertices)) {
+        cout << filename << ": " << next_id << " of " << header.nr_vertices << " verticies found" << endl;
+        return false;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    report.raw_bytes = cmesh.get_binary_size();
+    report.compressed_bytes = file_size;
+    report.seconds = chrono::duration<double>(end - start).count();
+
+    return true;
+}
+
+// largest coordinate difference of the seeds and of the verticies (compared cell by cell, the numbering of the
+// verticies may differ). -1 if the topology of the two meshes is not the same
+double MeshSnapshot::get_round_trip_error(const CompactMesh &a, const CompactMesh &b) {
+
+    if (a.seeds.size() != b.seeds.size() || a.cell_offsets != b.cell_offsets || a.cell_neighbours != b.cell_neighbours) {
+        return -1;
+    }
+
+    double max_error = 0;
+    for (size_t i = 0; i < a.seeds.size(); i++) {
+        max_error = max(max_error, max(fabs(a.seeds[i].x - b.seeds[i].x), fabs(a.seeds[i].y - b.seeds[i].y)));
+    }
+    for (size_t k = 0; k < a.cell_vertices.size(); k++) {
+        Point va = a.vertices[a.cell_vertices[k]];
+        Point vb = b.vertices[b.cell_vertices[k]];
+        max_error = max(max_error, max(fabs(va.x - vb.x), fabs(va.y - vb.y)));
+    }
+
+    return max_error;
+}
@@ -0,0 +1,65 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "CompactMesh.h"
+#include "HuffmanCoder.h"
+using namespace std;
+
+#ifndef MeshSnapshot_h
+#define MeshSnapshot_h
+
+#define SNAPSHOT_NR_STREAMS 8
+
+// compressed mesh file (.vmsnap): header followed by the SNAPSHOT_NR_STREAMS Huffman coded streams of varints
+//   0 cell ids         zigzag delta of the original index, cells in Hilbert curve order
+//   1,2 seed x, y      zigzag delta of the quantized coordinate to the cell before
+//   3 degrees          number of vertices of every cell
+//   4 neighbours       boundary -2..-5 as 0..3, otherwise 4 + zigzag delta of the curve position to the own one
+//   5 vertex refs      0 for a vertex seen the first time, otherwise how many new verticies ago it was seen
+//   6,7 vertex x, y    zigzag of the quantized coordinate minus the quantized seed of the cell that saw it first
+// coordinates are fixed point with bits bits over the unit square, stream_sizes are the bytes of the coded streams
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bits;
+    uint64_t nr_cells;
+    uint64_t nr_vertices;
+    uint64_t nr_cell_entries;
+    uint64_t stream_sizes[SNAPSHOT_NR_STREAMS];
+};
+
+const char SNAPSHOT_MAGIC[8] = {'V', 'M', 'P', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+// sizes and time of the last save or load
+struct snapshot_report
+    {
+        long long raw_bytes;            // the same mesh as binary mesh file (.vmsh)
+        long long compressed_bytes;     // the snapshot file
+        double seconds;
+    };
+
+// writes and reads compressed snapshots of a mesh. the topology is kept exactly, every seed and vertex coordinate
+// is off by at most get_error_bound() after the round trip
+class MeshSnapshot {
+
+public:
+    MeshSnapshot(int bits = 20);
+    ~MeshSnapshot();
+    int bits;
+    snapshot_report report;
+    bool save(const CompactMesh &cmesh, string filename);
+    bool load(string filename, CompactMesh &cmesh);
+    double get_error_bound() const;
+    static double get_round_trip_error(const CompactMesh &a, const CompactMesh &b);
+
+private:
+    HuffmanCoder coder;
+    vector<uint8_t> streams[SNAPSHOT_NR_STREAMS];
+    vector<uint8_t> block;
+    long long quantize(double x) const;
+    double dequantize(long long q) const;
+
+};
+
+#endif
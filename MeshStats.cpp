@@ -0,0 +1,118 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include "MeshStats.h"
+
+MeshStats::MeshStats() {
+    reset();
+}
+
+MeshStats::~MeshStats() {}
+
+void MeshStats::reset() {
+    inserts = 0;
+    walk_steps = 0;
+    max_walk_steps = 0;
+    halfplane_intersections = 0;
+    boundary_walk_iterations = 0;
+    degeneracy_checks = 0;
+    exact_predicates = 0;
+    construct_cell_fallbacks = 0;
+    clip_splices = 0;
+    knn_growths = 0;
+    halo_growths = 0;
+    point_location_time = 0;
+    cell_tracing_time = 0;
+    neighbour_clipping_time = 0;
+    cell_construction_time = 0;
+    triangulation_time = 0;
+    sweep_time = 0;
+    output_time = 0;
+}
+
+// add the counts of another mesh (tiles of the parallel point insertion, threads)
+void MeshStats::merge(const MeshStats &other) {
+    inserts += other.inserts;
+    walk_steps += other.walk_steps;
+    max_walk_steps = max(max_walk_steps, other.max_walk_steps);
+    halfplane_intersections += other.halfplane_intersections;
+    boundary_walk_iterations += other.boundary_walk_iterations;
+    degeneracy_checks += other.degeneracy_checks;
+    exact_predicates += other.exact_predicates;
+    construct_cell_fallbacks += other.construct_cell_fallbacks;
+    clip_splices += other.clip_splices;
+    knn_growths += other.knn_growths;
+    halo_growths += other.halo_growths;
+    point_location_time += other.point_location_time;
+    cell_tracing_time += other.cell_tracing_time;
+    neighbour_clipping_time += other.neighbour_clipping_time;
+    cell_construction_time += other.cell_construction_time;
+    triangulation_time += other.triangulation_time;
+    sweep_time += other.sweep_time;
+    output_time += other.output_time;
+}
+
+void MeshStats::print() const {
+
+    double per_insert = (inserts > 0) ? 1.0 / inserts : 0;
+
+    cout << "mesh statistics:" << endl;
+    cout << "  inserts:                  " << inserts << endl;
+    cout << "  walk steps:               " << walk_steps << "  (" << walk_steps * per_insert << " per insert, max " << max_walk_steps << ")" << endl;
+    cout << "  halfplane intersections:  " << halfplane_intersections << endl;
+    cout << "  boundary walk iterations: " << boundary_walk_iterations << endl;
+    cout << "  degeneracy checks:        " << degeneracy_checks << endl;
+    cout << "  exact predicates:         " << exact_predicates << endl;
+    cout << "  construct_cell fallbacks: " << construct_cell_fallbacks << endl;
+    cout << "  clip splices:             " << clip_splices << "  (" << clip_splices * per_insert << " per insert)" << endl;
+    cout << "  knn growths:              " << knn_growths << endl;
+    cout << "  halo growths:             " << halo_growths << endl;
+    cout << "  point location:           " << point_location_time << " s" << endl;
+    cout << "  cell tracing:             " << cell_tracing_time << " s" << endl;
+    cout << "  neighbour clipping:       " << neighbour_clipping_time << " s" << endl;
+    cout << "  cell construction:        " << cell_construction_time << " s" << endl;
+    cout << "  triangulation:            " << triangulation_time << " s" << endl;
+    cout << "  sweepline:                " << sweep_time << " s" << endl;
+    cout << "  output:                   " << output_time << " s" << endl;
+}
+
+bool MeshStats::save_to_json(string filename) const {
+
+    ofstream file(filename);
+    if (!file) {
+        cout << "could not open " << filename << " for writing" << endl;
+        return false;
+    }
+
+    file << setprecision(9);
+    file << "{\n";
+    file << "  \"inserts\": " << inserts << ",\n";
+    file << "  \"walk_steps\": " << walk_steps << ",\n";
+    file << "  \"max_walk_steps\": " << max_walk_steps << ",\n";
+    file << "  \"halfplane_intersections\": " << halfplane_intersections << ",\n";
+    file << "  \"boundary_walk_iterations\": " << boundary_walk_iterations << ",\n";
+    file << "  \"degeneracy_checks\": " << degeneracy_checks << ",\n";
+    file << "  \"exact_predicates\": " << exact_predicates << ",\n";
+    file << "  \"construct_cell_fallbacks\": " << construct_cell_fallbacks << ",\n";
+    file << "  \"clip_splices\": " << clip_splices << ",\n";
+    file << "  \"knn_growths\": " << knn_growths << ",\n";
+    file << "  \"halo_growths\": " << halo_growths << ",\n";
+    file << "  \"time_point_location\": " << point_location_time << ",\n";
+    file << "  \"time_cell_tracing\": " << cell_tracing_time << ",\n";
+    file << "  \"time_neighbour_clipping\": " << neighbour_clipping_time << ",\n";
+    file << "  \"time_cell_construction\": " << cell_construction_time << ",\n";
+    file << "  \"time_triangulation\": " << triangulation_time << ",\n";
+    file << "  \"time_sweepline\": " << sweep_time << ",\n";
+    file << "  \"time_output\": " << output_time << "\n";
+    file << "}\n";
+
+    return static_cast<bool>(file);
+}
+
+bool MeshStats::compiled_in() {
+#ifdef VMP_ENABLE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
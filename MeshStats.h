@@ -0,0 +1,55 @@
+#include <string>
+#include <chrono>
+#include <algorithm>
+using namespace std;
+
+#ifndef MeshStats_h
+#define MeshStats_h
+
+// counters and phase timers of the mesh generation. the hot paths only touch them through the VMP_STAT_* macros,
+// which compile to nothing unless VMP_ENABLE_STATS is defined (CMake option of the same name). times are summed
+// over all threads for the parallel algorithms.
+class MeshStats {
+
+public:
+    MeshStats();
+    ~MeshStats();
+    long long inserts;
+    long long walk_steps;
+    long long max_walk_steps;
+    long long halfplane_intersections;
+    long long boundary_walk_iterations;
+    long long degeneracy_checks;
+    long long exact_predicates;         // predicates the floating point filter could not decide
+    long long construct_cell_fallbacks;
+    long long clip_splices;
+    long long knn_growths;              // nearest seed searches that had to be repeated with a larger k
+    long long halo_growths;             // tile meshes of the parallel point insertion repeated with a wider halo
+    double point_location_time;         // in seconds
+    double cell_tracing_time;
+    double neighbour_clipping_time;
+    double cell_construction_time;      // halfplane intersection algorithm, dual cells of the Delaunay algorithm
+    double triangulation_time;          // Delaunay algorithm
+    double sweep_time;                  // sweepline algorithm
+    double output_time;
+    void reset();
+    void merge(const MeshStats &other);
+    void print() const;
+    bool save_to_json(string filename) const;
+    static bool compiled_in();
+
+};
+
+#ifdef VMP_ENABLE_STATS
+#define VMP_STAT_ADD(stats, counter, n) ((stats).counter += (n))
+#define VMP_STAT_MAX(stats, counter, n) ((stats).counter = max((stats).counter, static_cast<long long>(n)))
+#define VMP_STAT_TIMER_START(timer) chrono::steady_clock::time_point timer = chrono::steady_clock::now()
+#define VMP_STAT_TIMER_STOP(stats, field, timer) ((stats).field += chrono::duration<double>(chrono::steady_clock::now() - (timer)).count())
+#else
+#define VMP_STAT_ADD(stats, counter, n) ((void)0)
+#define VMP_STAT_MAX(stats, counter, n) ((void)0)
+#define VMP_STAT_TIMER_START(timer) ((void)0)
+#define VMP_STAT_TIMER_STOP(stats, field, timer) ((void)0)
+#endif
+
+#endif
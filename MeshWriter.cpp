@@ -0,0 +1,114 @@
+#include <chrono>
+#include "MeshWriter.h"
+
+MeshWriter::MeshWriter(int output_format, bool compress, int max_queued, int snapshot_bits) : snapshot(snapshot_bits) {
+    this->output_format = output_format;
+    this->compress = compress && compression_available();
+    this->max_queued = (max_queued < 1) ? 1 : max_queued;
+    stop = false;
+    wait_time = 0;
+    snapshot_total = snapshot_report{0, 0, 0};
+    writer = thread(&MeshWriter::writer_loop, this);
+}
+
+MeshWriter::~MeshWriter() {
+    finish();
+}
+
+bool MeshWriter::compression_available() {
+#ifdef VMP_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+// hand a finished mesh over to the writer thread (the mesh is moved, not copied)
+void MeshWriter::add_mesh(VoronoiMesh &&vmesh, int nr) {
+    push_frame(MeshFrame{move(vmesh), CompactMesh(), false, nr});
+}
+
+// hand a snapshot of a mesh over to the writer thread (the snapshot is moved, not copied)
+void MeshWriter::add_mesh(CompactMesh &&cmesh, int nr) {
+    push_frame(MeshFrame{VoronoiMesh(vector<Point>()), move(cmesh), true, nr});
+}
+
+void MeshWriter::push_frame(MeshFrame &&frame) {
+
+    auto start = chrono::high_resolution_clock::now();
+
+    unique_lock<mutex> lock(queue_mutex);
+    not_full_cv.wait(lock, [this] { return queue.size() < static_cast<size_t>(max_queued); });
+    queue.push_back(move(frame));
+    not_empty_cv.notify_one();
+
+    auto end = chrono::high_resolution_clock::now();
+    wait_time += chrono::duration<double>(end - start).count();
+}
+
+// write all queued meshes and stop the writer thread
+void MeshWriter::finish() {
+
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stop = true;
+    }
+    not_empty_cv.notify_one();
+
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+// seconds the producer spent waiting for a free slot in the queue (writing slower than meshing)
+double MeshWriter::get_wait_time() {
+    return wait_time;
+}
+
+// sizes and encoding time of all snapshots written so far (only complete after finish)
+snapshot_report MeshWriter::get_snapshot_report() {
+    lock_guard<mutex> lock(queue_mutex);
+    return snapshot_total;
+}
+
+void MeshWriter::writer_loop() {
+
+    while (true) {
+
+        unique_lock<mutex> lock(queue_mutex);
+        not_empty_cv.wait(lock, [this] { return stop || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+
+        // write the frame outside of the lock, it only leaves the queue afterwards so max_queued also bounds the frame in flight
+        MeshFrame &frame = queue.front();
+        lock.unlock();
+
+        if (frame.is_compact) {
+            if (output_format == 1) {
+                frame.cmesh.save_mesh_to_binary("files/mesh" + to_string(frame.nr) + ".vmsh");
+            } else if (output_format == 2) {
+                snapshot.save(frame.cmesh, "files/mesh" + to_string(frame.nr) + ".vmsnap");
+            } else {
+                frame.cmesh.save_mesh_to_files(frame.nr, compress);
+            }
+        } else if (output_format == 1) {
+            frame.mesh.save_mesh_to_binary(frame.nr);
+        } else if (output_format == 2) {
+            CompactMesh cmesh(frame.mesh);
+            snapshot.save(cmesh, "files/mesh" + to_string(frame.nr) + ".vmsnap");
+        } else {
+            frame.mesh.save_mesh_to_files(frame.nr, compress);
+        }
+
+        lock.lock();
+        if (output_format == 2) {
+            snapshot_total.raw_bytes += snapshot.report.raw_bytes;
+            snapshot_total.compressed_bytes += snapshot.report.compressed_bytes;
+            snapshot_total.seconds += snapshot.report.seconds;
+        }
+        queue.pop_front();
+        not_full_cv.notify_one();
+    }
+}
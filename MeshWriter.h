@@ -0,0 +1,54 @@
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "VoronoiMesh.h"
+#include "CompactMesh.h"
+#include "MeshSnapshot.h"
+using namespace std;
+
+#ifndef MeshWriter_h
+#define MeshWriter_h
+
+// writes finished meshes to files on a background thread, so the next mesh can be built while the last one is saved.
+// the queue holds at most max_queued meshes, add_mesh blocks while it is full (bounded memory for long animations).
+// output_format 0: csv files, 1: binary mesh files, 2: compressed snapshots with snapshot_bits bits per coordinate.
+// a mesh that is still needed by the producer (e.g. the incremental moving mesh) is handed over as a CompactMesh
+// snapshot instead of a copy of all cells
+class MeshWriter {
+
+public:
+    MeshWriter(int output_format, bool compress, int max_queued, int snapshot_bits = 20);
+    ~MeshWriter();
+    int output_format;
+    bool compress;
+    int max_queued;
+    void add_mesh(VoronoiMesh &&vmesh, int nr);
+    void add_mesh(CompactMesh &&cmesh, int nr);
+    void finish();
+    double get_wait_time();
+    snapshot_report get_snapshot_report();
+    static bool compression_available();
+
+private:
+    struct MeshFrame {
+        VoronoiMesh mesh;
+        CompactMesh cmesh;      // used instead of mesh if is_compact
+        bool is_compact;
+        int nr;
+    };
+    deque<MeshFrame> queue;
+    mutex queue_mutex;
+    condition_variable not_empty_cv;
+    condition_variable not_full_cv;
+    thread writer;
+    bool stop;
+    double wait_time;
+    MeshSnapshot snapshot;
+    snapshot_report snapshot_total;     // summed over all written snapshots
+    void push_frame(MeshFrame &&frame);
+    void writer_loop();
+
+};
+
+#endif
@@ -0,0 +1,319 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "RobustPredicates.h"
+
+// the error free transformations below need every operation rounded on its own, this file is compiled without
+// contraction into fused multiply adds (see CMakeLists.txt)
+
+// an expansion is a sum of doubles of increasing magnitude that do not overlap, the last one carries the sign. they
+// are stored in arrays with their length, the exact path works in a workspace per thread that is allocated once
+static const double epsilon = 1.1102230246251565e-16;      // 2^-53
+static const double splitter = 134217729.0;                 // 2^27 + 1
+
+// bounds of the rounding error of the floating point determinants relative to their permanents (a bit wider than
+// the classic ones because the differences of mirrored sites are rounded twice)
+static const double orient_error_bound = 8 * epsilon;
+static const double incircle_error_bound = 32 * epsilon;
+
+static thread_local long long exact_predicate_count = 0;
+
+// x + y = a + b exactly
+static inline void two_sum(double a, double b, double &x, double &y) {
+    x = a + b;
+    double b_virtual = x - a;
+    double a_virtual = x - b_virtual;
+    y = (a - a_virtual) + (b - b_virtual);
+}
+
+// x + y = a * b exactly
+static inline void two_product(double a, double b, double &x, double &y) {
+    x = a * b;
+    double c = splitter * a;
+    double a_hi = c - (c - a);
+    double a_lo = a - a_hi;
+    c = splitter * b;
+    double b_hi = c - (c - b);
+    double b_lo = b - b_hi;
+    double err = x - a_hi * b_hi;
+    err -= a_lo * b_hi;
+    err -= a_hi * b_lo;
+    y = a_lo * b_lo - err;
+}
+
+// h = e + b, zero components are dropped, h may be e. returns the length of h
+static int grow_expansion(int e_length, const double *e, double b, double *h) {
+    double q = b;
+    int h_length = 0;
+    for (int i = 0; i < e_length; i++) {
+        double sum, err;
+        two_sum(q, e[i], sum, err);
+        q = sum;
+        if (err != 0) {
+            h[h_length++] = err;
+        }
+    }
+    if (q != 0 || h_length == 0) {
+        h[h_length++] = q;
+    }
+    return h_length;
+}
+
+// h = h + sign * f in place, h has room for h_length + f_length components
+static int add_expansion(int h_length, double *h, int f_length, const double *f, double sign = 1) {
+    for (int i = 0; i < f_length; i++) {
+        h_length = grow_expansion(h_length, h, sign * f[i], h);
+    }
+    return h_length;
+}
+
+// h = e + sign * f, h has room for e_length + f_length components
+static int expansion_sum(int e_length, const double *e, int f_length, const double *f, double *h, double sign = 1) {
+    copy(e, e + e_length, h);
+    return add_expansion(e_length, h, f_length, f, sign);
+}
+
+// h = e * b, h has room for 2 * e_length components
+static int scale_expansion(int e_length, const double *e, double b, double *h) {
+    int h_length = 0;
+    double q, err;
+    two_product(e[0], b, q, err);
+    if (err != 0) {
+        h[h_length++] = err;
+    }
+    for (int i = 1; i < e_length; i++) {
+        double product1, product0, sum;
+        two_product(e[i], b, product1, product0);
+        two_sum(q, product0, sum, err);
+        if (err != 0) {
+            h[h_length++] = err;
+        }
+        two_sum(product1, sum, q, err);
+        if (err != 0) {
+            h[h_length++] = err;
+        }
+    }
+    if (q != 0 || h_length == 0) {
+        h[h_length++] = q;
+    }
+    return h_length;
+}
+
+// h = e * f, h has room for 2 * e_length * f_length components, scratch for 2 * e_length
+static int expansion_product(int e_length, const double *e, int f_length, const double *f, double *h, double *scratch) {
+    h[0] = 0;
+    int h_length = 1;
+    for (int i = 0; i < f_length; i++) {
+        int scaled_length = scale_expansion(e_length, e, f[i], scratch);
+        h_length = add_expansion(h_length, h, scaled_length, scratch);
+    }
+    return h_length;
+}
+
+static int expansion_sign(int e_length, const double *e) {
+    return (e[e_length - 1] > 0) - (e[e_length - 1] < 0);
+}
+
+// a coordinate of a site is offset + sign * value of the seed coordinate: mirroring at x=1 gives 2 - x, at x=0 -x
+static void site_coordinate(const PredicateSite &s, bool y_coordinate, double &offset, double &value) {
+
+    int upper = y_coordinate ? -2 : -3;
+    int lower = y_coordinate ? -4 : -5;
+    value = y_coordinate ? s.pt.y : s.pt.x;
+    offset = 0;
+    if (s.mirror == upper) {
+        offset = 2;
+        value = -value;
+    } else if (s.mirror == lower) {
+        value = -value;
+    }
+}
+
+// a - d in one coordinate, exact, h has room for 3 components
+static int site_difference(const PredicateSite &a, const PredicateSite &d, bool y_coordinate, double *h) {
+
+    double offset_a, value_a, offset_d, value_d;
+    site_coordinate(a, y_coordinate, offset_a, value_a);
+    site_coordinate(d, y_coordinate, offset_d, value_d);
+
+    double e[2];
+    two_sum(value_a, -value_d, e[1], e[0]);
+    return grow_expansion(2, e, offset_a - offset_d, h);
+}
+
+// a - d in one coordinate, rounded (once for seeds, the mirror images add one more rounding)
+static inline double approximate_difference(const PredicateSite &a, const PredicateSite &d, bool y_coordinate) {
+
+    if (a.mirror == 0 && d.mirror == 0) {
+        return y_coordinate ? a.pt.y - d.pt.y : a.pt.x - d.pt.x;
+    }
+    double offset_a, value_a, offset_d, value_d;
+    site_coordinate(a, y_coordinate, offset_a, value_a);
+    site_coordinate(d, y_coordinate, offset_d, value_d);
+
+    double sum, err;
+    two_sum(value_a, -value_d, sum, err);
+    return ((offset_a - offset_d) + sum) + err;
+}
+
+PredicateSite make_site(Point pt, int rank) {
+    PredicateSite site;
+    site.pt = pt;
+    site.mirror = 0;
+    site.rank = rank;
+    return site;
+}
+
+// mirror images rank below all seeds, the boundary index keeps them apart
+PredicateSite make_mirror_site(Point pt, int boundary_index) {
+    PredicateSite site;
+    site.pt = pt;
+    site.mirror = boundary_index;
+    site.rank = boundary_index;
+    return site;
+}
+
+int orient2d_sign(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c) {
+
+    double acx = approximate_difference(a, c, false);
+    double acy = approximate_difference(a, c, true);
+    double bcx = approximate_difference(b, c, false);
+    double bcy = approximate_difference(b, c, true);
+
+    double det_left = acx * bcy;
+    double det_right = acy * bcx;
+    double det = det_left - det_right;
+    double error_bound = orient_error_bound * (fabs(det_left) + fabs(det_right));
+    if (det > error_bound || -det > error_bound) {
+        return (det > 0) - (det < 0);
+    }
+
+    // 3 component differences: products of up to 18, determinant of up to 36 components
+    exact_predicate_count += 1;
+    double acx_exact[3], acy_exact[3], bcx_exact[3], bcy_exact[3];
+    int acx_length = site_difference(a, c, false, acx_exact);
+    int acy_length = site_difference(a, c, true, acy_exact);
+    int bcx_length = site_difference(b, c, false, bcx_exact);
+    int bcy_length = site_difference(b, c, true, bcy_exact);
+
+    double left[18], right[18], scratch[12], exact[36];
+    int left_length = expansion_product(acx_length, acx_exact, bcy_length, bcy_exact, left, scratch);
+    int right_length = expansion_product(acy_length, acy_exact, bcx_length, bcx_exact, right, scratch);
+    int exact_length = expansion_sum(left_length, left, right_length, right, exact, -1);
+    return expansion_sign(exact_length, exact);
+}
+
+int incircle_sign(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c, const PredicateSite &d) {
+
+    double adx = approximate_difference(a, d, false);
+    double ady = approximate_difference(a, d, true);
+    double bdx = approximate_difference(b, d, false);
+    double bdy = approximate_difference(b, d, true);
+    double cdx = approximate_difference(c, d, false);
+    double cdy = approximate_difference(c, d, true);
+
+    double bdxcdy = bdx * cdy;
+    double cdxbdy = cdx * bdy;
+    double alift = adx * adx + ady * ady;
+    double cdxady = cdx * ady;
+    double adxcdy = adx * cdy;
+    double blift = bdx * bdx + bdy * bdy;
+    double adxbdy = adx * bdy;
+    double bdxady = bdx * ady;
+    double clift = cdx * cdx + cdy * cdy;
+
+    double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * alift + (fabs(cdxady) + fabs(adxcdy)) * blift
+                     + (fabs(adxbdy) + fabs(bdxady)) * clift;
+    double error_bound = incircle_error_bound * permanent;
+    if (det > error_bound || -det > error_bound) {
+        return (det > 0) - (det < 0);
+    }
+
+    // same determinant in expansion arithmetic: 3 component differences, lifts and 2x2 minors of up to 36
+    // components, their products of up to 2592 and the determinant of up to 7776
+    exact_predicate_count += 1;
+    static thread_local vector<double> workspace;
+    workspace.resize(6 * 36 + 3 * 2592 + 2 * 7776 + 2 * 72 + 2 * 36);
+    double *lift[3], *minor[3], *term[3];
+    for (int i = 0; i < 3; i++) {
+        lift[i] = workspace.data() + i * 36;
+        minor[i] = workspace.data() + (3 + i) * 36;
+        term[i] = workspace.data() + 6 * 36 + i * 2592;
+    }
+    double *partial = workspace.data() + 6 * 36 + 3 * 2592;
+    double *exact = partial + 7776;
+    double *scratch = exact + 7776;
+    double *square = scratch + 2 * 72;
+    double *other_square = square + 36;
+
+    const PredicateSite *sites[3] = {&a, &b, &c};
+    double dx[3][3], dy[3][3];
+    int dx_length[3], dy_length[3];
+    for (int i = 0; i < 3; i++) {
+        dx_length[i] = site_difference(*sites[i], d, false, dx[i]);
+        dy_length[i] = site_difference(*sites[i], d, true, dy[i]);
+    }
+
+    // lift of site i and the minor of the two other sites (b c, c a, a b)
+    int lift_length[3], minor_length[3], term_length[3];
+    for (int i = 0; i < 3; i++) {
+        int square_length = expansion_product(dx_length[i], dx[i], dx_length[i], dx[i], square, scratch);
+        int other_length = expansion_product(dy_length[i], dy[i], dy_length[i], dy[i], other_square, scratch);
+        lift_length[i] = expansion_sum(square_length, square, other_length, other_square, lift[i]);
+
+        int j = (i + 1) % 3;
+        int k = (i + 2) % 3;
+        square_length = expansion_product(dx_length[j], dx[j], dy_length[k], dy[k], square, scratch);
+        other_length = expansion_product(dx_length[k], dx[k], dy_length[j], dy[j], other_square, scratch);
+        minor_length[i] = expansion_sum(square_length, square, other_length, other_square, minor[i], -1);
+    }
+    for (int i = 0; i < 3; i++) {
+        term_length[i] = expansion_product(lift_length[i], lift[i], minor_length[i], minor[i], term[i], scratch);
+    }
+
+    int partial_length = expansion_sum(term_length[0], term[0], term_length[1], term[1], partial);
+    int exact_length = expansion_sum(partial_length, partial, term_length[2], term[2], exact);
+    return expansion_sign(exact_length, exact);
+}
+
+int incircle_sign_perturbed(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c, const PredicateSite &d) {
+
+    int det = incircle_sign(a, b, c, d);
+    if (det != 0) {
+        return det;
+    }
+
+    // the incircle determinant is the 4x4 determinant of the rows (x, y, x^2 + y^2, 1). raising the lifted
+    // coordinate of site i by eps_i adds eps_i * (-1)^i * orient(other three sites), the term of the site with
+    // the highest rank decides, or the next one if the other three are collinear
+    const PredicateSite *sites[4] = {&a, &b, &c, &d};
+    int order[4] = {0, 1, 2, 3};
+    sort(order, order + 4, [&sites](int i, int j) { return sites[i]->rank > sites[j]->rank; });
+
+    for (int k = 0; k < 4 && det == 0; k++) {
+        int i = order[k];
+        const PredicateSite *others[3];
+        int n = 0;
+        for (int j = 0; j < 4; j++) {
+            if (j != i) {
+                others[n++] = sites[j];
+            }
+        }
+        det = orient2d_sign(*others[0], *others[1], *others[2]) * ((i % 2 == 0) ? 1 : -1);
+    }
+    return det;
+}
+
+bool in_circle_perturbed(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c, const PredicateSite &d) {
+
+    int orientation = orient2d_sign(a, b, c);
+    if (orientation == 0) {
+        return false;
+    }
+    return incircle_sign_perturbed(a, b, c, d) * orientation > 0;
+}
+
+long long get_exact_predicate_count() {
+    return exact_predicate_count;
+}
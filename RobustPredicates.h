@@ -0,0 +1,37 @@
+#include "Point.h"
+using namespace std;
+
+#ifndef RobustPredicates_h
+#define RobustPredicates_h
+
+// a site of the geometric predicates: a seed, or the mirror image of a seed at one of the boundaries of the unit
+// square. mirror is 0 for the seed itself or the index of the boundary halfplane (-2: y=1, -3: x=1, -4: y=0,
+// -5: x=0). mirror images are never rounded, the predicates work with the seed and the mirror line.
+struct PredicateSite
+    {
+        Point pt;
+        int mirror;
+        int rank;       // order of the symbolic perturbation: the site with the highest rank is perturbed most
+    };
+
+PredicateSite make_site(Point pt, int rank);
+PredicateSite make_mirror_site(Point pt, int boundary_index);
+
+// exact signs, computed in floating point if the error bound allows it and with expansion arithmetic otherwise
+//   orient2d_sign:  +1 if a, b, c are counterclockwise, -1 if clockwise, 0 if collinear
+//   incircle_sign:  +1 if d is inside the circle through a, b, c (counterclockwise), 0 if cocircular
+int orient2d_sign(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c);
+int incircle_sign(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c, const PredicateSite &d);
+
+// incircle_sign with cocircular sites decided by simulation of simplicity: the lifted sites are raised by
+// infinitesimals ordered by rank, so a site of higher rank than the others is outside of their circle. only 0 if
+// all four sites are collinear
+int incircle_sign_perturbed(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c, const PredicateSite &d);
+
+// is d strictly inside the circumcircle of a, b, c (any orientation, perturbed as above)? false if a, b, c are collinear
+bool in_circle_perturbed(const PredicateSite &a, const PredicateSite &b, const PredicateSite &c, const PredicateSite &d);
+
+// number of predicates this thread had to evaluate exactly (for the statistics)
+long long get_exact_predicate_count();
+
+#endif
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <algorithm>
+#include "SeedGrid.h"
+
+SeedGrid::SeedGrid() {
+    grid_size = 0;
+    bucket_width = 1;
+}
+
+// sort all points into a uniform grid over the unit square with about pts_per_bucket points per bucket
+SeedGrid::SeedGrid(const vector<Point> &pts, double pts_per_bucket) {
+
+    grid_size = static_cast<int>(ceil(sqrt(pts.size() / pts_per_bucket)));
+    if (grid_size < 1) {
+        grid_size = 1;
+    }
+    if (grid_size > 32768) {
+        grid_size = 32768;
+    }
+    bucket_width = 1.0 / grid_size;
+
+    // count points per bucket
+    vector<int> bucket_of_pt(pts.size());
+    bucket_start.assign(grid_size * grid_size + 1, 0);
+    for (int i = 0; i < pts.size(); i++) {
+        bucket_of_pt[i] = get_bucket_coord(pts[i].y) * grid_size + get_bucket_coord(pts[i].x);
+        bucket_start[bucket_of_pt[i] + 1] += 1;
+    }
+
+    // prefix sum -> bucket offsets
+    for (int i = 0; i < grid_size * grid_size; i++) {
+        bucket_start[i + 1] += bucket_start[i];
+    }
+
+    // fill buckets (counting sort keeps the point order inside a bucket)
+    vector<int> fill = bucket_start;
+    bucket_pts.resize(pts.size());
+    for (int i = 0; i < pts.size(); i++) {
+        bucket_pts[fill[bucket_of_pt[i]]] = i;
+        fill[bucket_of_pt[i]] += 1;
+    }
+}
+
+SeedGrid::~SeedGrid() {}
+
+// bucket coordinate of a position, clamped to the grid
+int SeedGrid::get_bucket_coord(double x) const {
+
+    int coord = static_cast<int>(x * grid_size);
+    if (coord < 0) {
+        coord = 0;
+    }
+    if (coord >= grid_size) {
+        coord = grid_size - 1;
+    }
+    return coord;
+}
+
+// append indices of all points in buckets with chebyshev distance == ring from bucket (bx, by)
+void SeedGrid::get_ring(int bx, int by, int ring, vector<int> &indices) const {
+
+    for (int j = by - ring; j <= by + ring; j++) {
+
+        if (j < 0 || j >= grid_size) {
+            continue;
+        }
+
+        // inner rows only have the two outermost buckets
+        int step = (j == by - ring || j == by + ring) ? 1 : 2 * ring;
+        if (step == 0) {
+            step = 1;
+        }
+
+        for (int i = bx - ring; i <= bx + ring; i += step) {
+            if (i < 0 || i >= grid_size) {
+                continue;
+            }
+            int bucket = j * grid_size + i;
+            for (int k = bucket_start[bucket]; k < bucket_start[bucket + 1]; k++) {
+                indices.push_back(bucket_pts[k]);
+            }
+        }
+    }
+}
+
+// every point closer than this to a seed in bucket (bx, by) is found in rings 0 to ring
+double SeedGrid::get_covered_radius(int ring) const {
+    return ring * bucket_width;
+}
+
+// true if rings 0 to ring around bucket (bx, by) contain the whole grid
+bool SeedGrid::covers_all(int bx, int by, int ring) const {
+    return bx - ring <= 0 && by - ring <= 0 && bx + ring >= grid_size - 1 && by + ring >= grid_size - 1;
+}
+
+// the k points closest to pt, sorted by distance (equal distances by index), fewer if there are not that many. rings
+// are added until k points lie within the radius the rings are known to cover: ring bucket widths plus the distance
+// of pt to the border of its own bucket
+void SeedGrid::get_nearest(const vector<Point> &pts, Point pt, int k, vector<nearest_seed> &nearest) const {
+
+    int bx = get_bucket_coord(pt.x);
+    int by = get_bucket_coord(pt.y);
+    double border_dist = min(min(pt.x - bx * bucket_width, (bx + 1) * bucket_width - pt.x),
+                             min(pt.y - by * bucket_width, (by + 1) * bucket_width - pt.y));
+    border_dist = max(border_dist, 0.0);
+    auto closer = [](const nearest_seed &a, const nearest_seed &b) {
+        return a.dist_squared < b.dist_squared || (a.dist_squared == b.dist_squared && a.index < b.index);
+    };
+
+    nearest.clear();
+    int nr_covered = 0;
+    for (int ring = 0; ; ring++) {
+
+        for (int j = by - ring; j <= by + ring; j++) {
+            if (j < 0 || j >= grid_size) {
+                continue;
+            }
+            int step = (j == by - ring || j == by + ring || ring == 0) ? 1 : 2 * ring;
+            for (int i = bx - ring; i <= bx + ring; i += step) {
+                if (i < 0 || i >= grid_size) {
+                    continue;
+                }
+                int bucket = j * grid_size + i;
+                for (int b = bucket_start[bucket]; b < bucket_start[bucket + 1]; b++) {
+                    nearest_seed candidate;
+                    candidate.index = bucket_pts[b];
+                    double dx = pts[candidate.index].x - pt.x;
+                    double dy = pts[candidate.index].y - pt.y;
+                    candidate.dist_squared = dx*dx + dy*dy;
+                    nearest.push_back(candidate);
+                }
+            }
+        }
+
+        if (covers_all(bx, by, ring)) {
+            nr_covered = nearest.size();
+            break;
+        }
+
+        // move the points within the covered radius to the front
+        double covered_radius = get_covered_radius(ring) + border_dist;
+        double covered_squared = covered_radius * covered_radius;
+        nr_covered = 0;
+        for (int i = 0; i < nearest.size(); i++) {
+            if (nearest[i].dist_squared <= covered_squared) {
+                swap(nearest[i], nearest[nr_covered]);
+                nr_covered++;
+            }
+        }
+        if (nr_covered >= k) {
+            break;
+        }
+    }
+
+    if (nr_covered > k) {
+        nth_element(nearest.begin(), nearest.begin() + k - 1, nearest.begin() + nr_covered, closer);
+        nr_covered = k;
+    }
+    nearest.resize(nr_covered);
+    sort(nearest.begin(), nearest.end(), closer);
+}
@@ -0,0 +1,33 @@
+#include <vector>
+#include "Point.h"
+using namespace std;
+
+#ifndef SeedGrid_h
+#define SeedGrid_h
+
+// seed found by SeedGrid::get_nearest
+struct nearest_seed
+    {
+        double dist_squared;
+        int index;
+    };
+
+class SeedGrid {
+
+public:
+    SeedGrid();
+    SeedGrid(const vector<Point> &pts, double pts_per_bucket);
+    ~SeedGrid();
+    int grid_size;
+    double bucket_width;
+    vector<int> bucket_start;
+    vector<int> bucket_pts;
+    int get_bucket_coord(double x) const;
+    void get_ring(int bx, int by, int ring, vector<int> &indices) const;
+    double get_covered_radius(int ring) const;
+    bool covers_all(int bx, int by, int ring) const;
+    void get_nearest(const vector<Point> &pts, Point pt, int k, vector<nearest_seed> &nearest) const;
+
+};
+
+#endif
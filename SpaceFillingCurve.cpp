@@ -0,0 +1,163 @@
+#include <random>
+#include <algorithm>
+#include "SpaceFillingCurve.h"
+
+// map a coordinate of the unit square onto 32 bit fixed point (values outside are clamped)
+uint32_t quantize_coordinate(double x) {
+
+    if (!(x > 0)) {
+        return 0;
+    }
+    if (x >= 1) {
+        return 0xFFFFFFFFu;
+    }
+    return static_cast<uint32_t>(x * 4294967296.0);
+}
+
+// spread the 32 bits of x to the even bits of a 64 bit integer
+static uint64_t spread_bits(uint32_t x) {
+
+    uint64_t v = x;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2)) & 0x3333333333333333ull;
+    v = (v | (v << 1)) & 0x5555555555555555ull;
+    return v;
+}
+
+// position of the point along the Morton (Z-order) curve through the unit square
+uint64_t get_morton_key(Point pt) {
+    return spread_bits(quantize_coordinate(pt.x)) | (spread_bits(quantize_coordinate(pt.y)) << 1);
+}
+
+// position of the point along the Peano-Hilbert curve of order 32 through the unit square
+uint64_t get_hilbert_key(Point pt) {
+
+    uint32_t x = quantize_coordinate(pt.x);
+    uint32_t y = quantize_coordinate(pt.y);
+    uint64_t d = 0;
+
+    for (uint32_t s = 1u << 31; s > 0; s >>= 1) {
+
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * static_cast<uint64_t>(s) * ((3 * rx) ^ ry);
+
+        // rotate the quadrant so that the lower bits follow the curve (higher bits are already used)
+        if (ry == 0) {
+            if (rx == 1) {
+                x = ~x;
+                y = ~y;
+            }
+            uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+
+    return d;
+}
+
+// returns the permutation that sorts keys ascending (stable LSD radix sort with 8 bit digits)
+vector<int> radix_sort_keys(const vector<uint64_t> &keys) {
+
+    int n = keys.size();
+    vector<int> order(n);
+    vector<int> buffer(n);
+    vector<uint64_t> sorted_keys = keys;
+    vector<uint64_t> key_buffer(n);
+
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+
+    for (int shift = 0; shift < 64; shift += 8) {
+
+        // histogram of the current digit
+        long long count[257] = {0};
+        for (int i = 0; i < n; i++) {
+            count[((sorted_keys[i] >> shift) & 0xFF) + 1] += 1;
+        }
+
+        // skip the pass if all keys share this digit
+        bool trivial = false;
+        for (int d = 1; d <= 256; d++) {
+            if (count[d] == n) {
+                trivial = true;
+            }
+        }
+        if (trivial) {
+            continue;
+        }
+
+        for (int d = 0; d < 256; d++) {
+            count[d + 1] += count[d];
+        }
+
+        // scatter into buffers
+        for (int i = 0; i < n; i++) {
+            int digit = (sorted_keys[i] >> shift) & 0xFF;
+            key_buffer[count[digit]] = sorted_keys[i];
+            buffer[count[digit]] = order[i];
+            count[digit] += 1;
+        }
+
+        sorted_keys.swap(key_buffer);
+        order.swap(buffer);
+    }
+
+    return order;
+}
+
+// biased randomized insertion order: the points are shuffled and split into rounds of doubling size (the last round
+// is the second half of the points, the one before a quarter, ...), within a round they follow the hilbert curve.
+// returns the order as indices into pts, the shuffle only depends on random_seed
+vector<int> get_brio_order(const vector<Point> &pts, uint64_t random_seed) {
+
+    int n = pts.size();
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+
+    // fisher yates shuffle (not std::shuffle, its result differs between standard libraries)
+    mt19937_64 generator(random_seed);
+    for (int i = n - 1; i > 0; i--) {
+        int j = generator() % (i + 1);
+        swap(order[i], order[j]);
+    }
+
+    // round boundaries from the back, the first round keeps at most 16 points
+    vector<int> round_start;
+    int start = n;
+    while (start > 16) {
+        start /= 2;
+        round_start.push_back(start);
+    }
+    round_start.push_back(0);
+    reverse(round_start.begin(), round_start.end());
+    round_start.push_back(n);
+
+    // hilbert order inside every round
+    vector<uint64_t> keys;
+    vector<int> round;
+    for (int r = 0; r + 1 < round_start.size(); r++) {
+
+        int begin = round_start[r];
+        int end = round_start[r + 1];
+
+        keys.resize(end - begin);
+        round.assign(order.begin() + begin, order.begin() + end);
+        for (int k = 0; k < keys.size(); k++) {
+            keys[k] = get_hilbert_key(pts[round[k]]);
+        }
+
+        vector<int> sorted = radix_sort_keys(keys);
+        for (int k = 0; k < sorted.size(); k++) {
+            order[begin + k] = round[sorted[k]];
+        }
+    }
+
+    return order;
+}
@@ -0,0 +1,15 @@
+#include <vector>
+#include <cstdint>
+#include "Point.h"
+using namespace std;
+
+#ifndef SpaceFillingCurve_h
+#define SpaceFillingCurve_h
+
+uint32_t quantize_coordinate(double x);
+uint64_t get_morton_key(Point pt);
+uint64_t get_hilbert_key(Point pt);
+vector<int> radix_sort_keys(const vector<uint64_t> &keys);
+vector<int> get_brio_order(const vector<Point> &pts, uint64_t random_seed = 42);
+
+#endif
@@ -0,0 +1,127 @@
+#include "ThreadPool.h"
+
+// start n_threads-1 workers, the calling thread always works as thread 0
+ThreadPool::ThreadPool(int n_threads) {
+
+    nr_threads = n_threads;
+    if (nr_threads < 1) {
+        nr_threads = hardware_threads();
+    }
+
+    current_task = nullptr;
+    next_index = 0;
+    job_size = 0;
+    job_chunk = 1;
+    job_generation = 0;
+    active_workers = 0;
+    stop = false;
+
+    for (int i = 1; i < nr_threads; i++) {
+        workers.push_back(thread(&ThreadPool::worker_loop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+
+    {
+        lock_guard<mutex> lock(pool_mutex);
+        stop = true;
+    }
+    job_cv.notify_all();
+
+    for (int i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+// number of threads the machine can run concurrently (at least 1)
+int ThreadPool::hardware_threads() {
+
+    int n = thread::hardware_concurrency();
+    if (n < 1) {
+        n = 1;
+    }
+    return n;
+}
+
+// call task(begin, end, thread_id) on chunks of [0, n) until all indices are done, returns when all chunks are finished
+void ThreadPool::parallel_for(int n, int chunk_size, const function<void(int, int, int)> &task) {
+
+    if (n <= 0) {
+        return;
+    }
+
+    // choose chunk size so that every thread gets a few chunks for load balancing
+    if (chunk_size < 1) {
+        chunk_size = n / (16 * nr_threads);
+        if (chunk_size < 1) {
+            chunk_size = 1;
+        }
+    }
+
+    // no workers -> just run the task on this thread
+    if (workers.empty()) {
+        task(0, n, 0);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(pool_mutex);
+        current_task = &task;
+        job_size = n;
+        job_chunk = chunk_size;
+        next_index = 0;
+        active_workers = workers.size();
+        job_generation += 1;
+    }
+    job_cv.notify_all();
+
+    // calling thread takes part in the work as well
+    run_chunks(0);
+
+    // wait for the workers to finish their last chunks
+    unique_lock<mutex> lock(pool_mutex);
+    done_cv.wait(lock, [this] { return active_workers == 0; });
+    current_task = nullptr;
+}
+
+// grab chunks of the current job until there are none left
+void ThreadPool::run_chunks(int thread_id) {
+
+    while (true) {
+        int begin = next_index.fetch_add(job_chunk);
+        if (begin >= job_size) {
+            break;
+        }
+        int end = begin + job_chunk;
+        if (end > job_size) {
+            end = job_size;
+        }
+        (*current_task)(begin, end, thread_id);
+    }
+}
+
+// workers sleep until a new job generation is published
+void ThreadPool::worker_loop(int thread_id) {
+
+    int seen_generation = 0;
+
+    while (true) {
+
+        unique_lock<mutex> lock(pool_mutex);
+        job_cv.wait(lock, [&] { return stop || job_generation != seen_generation; });
+        if (stop) {
+            return;
+        }
+        seen_generation = job_generation;
+        lock.unlock();
+
+        run_chunks(thread_id);
+
+        lock.lock();
+        active_workers -= 1;
+        if (active_workers == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
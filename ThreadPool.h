@@ -0,0 +1,38 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+using namespace std;
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+class ThreadPool {
+
+public:
+    ThreadPool(int n_threads);
+    ~ThreadPool();
+    int nr_threads;
+    void parallel_for(int n, int chunk_size, const function<void(int, int, int)> &task);
+    static int hardware_threads();
+
+private:
+    vector<thread> workers;
+    mutex pool_mutex;
+    condition_variable job_cv;
+    condition_variable done_cv;
+    const function<void(int, int, int)> *current_task;
+    atomic<int> next_index;
+    int job_size;
+    int job_chunk;
+    int job_generation;
+    int active_workers;
+    bool stop;
+    void worker_loop(int thread_id);
+    void run_chunks(int thread_id);
+
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include "Point.h"
+#include "VoronoiCell.h"
+using namespace std;
+
+#ifndef TileRegion_h
+#define TileRegion_h
+
+// region of the unit square whose seeds a tile mesh knows: the tile plus a halo of ghost seeds around it. both tiled
+// builds (VoronoiMesh::do_parallel_point_insertion in memory, TiledMesher out of core) use it, so they agree on how
+// wide the halo starts, which cells of a tile mesh are final and how the halo grows when some are not
+class TileRegion {
+
+public:
+    TileRegion(int tx, int ty, double tile_width, double halo_width);
+    ~TileRegion();
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+    bool contains(Point pt) const;
+    bool covers(const VoronoiCell &cell) const;
+    static double get_halo_width(long long n_seeds);
+    static double widen_halo(double halo_width, double tile_width);
+
+};
+
+#endif
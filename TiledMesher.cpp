@@ -0,0 +1,355 @@
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "TiledMesher.h"
+#include "ThreadPool.h"
+#include "SpaceFillingCurve.h"
+#include "TileRegion.h"
+
+// seeds kept in memory per tile file before they are appended to it
+#define TILED_BUFFER_SEEDS 2048
+
+// output of a tile collected before it is written (in bytes)
+#define TILED_OUTPUT_CHUNK (1 << 20)
+
+TiledMesher::TiledMesher(int tiles_per_dim, double halo_width, string work_dir, int n_threads) {
+    this->tiles_per_dim = (tiles_per_dim < 1) ? 1 : tiles_per_dim;
+    this->halo_width = halo_width;
+    this->work_dir = work_dir;
+    this->n_threads = n_threads;
+    print_progress = true;
+    report = tiled_report{0, 0, 0, 0, 0, 0, 0, 0};
+    nr_seeds = 0;
+
+    int nr_tiles = this->tiles_per_dim * this->tiles_per_dim;
+    tile_buffers.resize(nr_tiles);
+    halo_buffers.resize(nr_tiles);
+
+    // left over from an interrupted run
+    remove_tile_files();
+}
+
+TiledMesher::~TiledMesher() {
+    remove_tile_files();
+}
+
+// tiles per side for tiles of about seeds_per_tile seeds (uniformly distributed)
+int TiledMesher::get_tiles_per_dim(long long n_seeds, long long seeds_per_tile) {
+    int tiles = static_cast<int>(ceil(sqrt(static_cast<double>(n_seeds) / max(seeds_per_tile, 1LL))));
+    return (tiles < 1) ? 1 : tiles;
+}
+
+// tile coordinate of a position, clamped to the tiles
+int TiledMesher::tile_coord(double x) {
+    int t = static_cast<int>(x * tiles_per_dim);
+    return t < 0 ? 0 : (t >= tiles_per_dim ? tiles_per_dim - 1 : t);
+}
+
+string TiledMesher::get_tile_filename(int tile, bool halo) {
+    return work_dir + (halo ? "/halo" : "/tile") + to_string(tile) + ".bin";
+}
+
+// append the buffered seeds to the tile file, the buffer keeps its capacity
+bool TiledMesher::flush_buffer(int tile, bool halo) {
+
+    vector<tiled_seed> &buffer = halo ? halo_buffers[tile] : tile_buffers[tile];
+    if (buffer.empty()) {
+        return true;
+    }
+
+    string filename = get_tile_filename(tile, halo);
+    FILE *file = fopen(filename.c_str(), "ab");
+    if (file == nullptr) {
+        cout << "could not open " << filename << " for writing" << endl;
+        return false;
+    }
+    bool success = fwrite(buffer.data(), sizeof(tiled_seed), buffer.size(), file) == buffer.size();
+    fclose(file);
+
+    buffer.clear();
+    return success;
+}
+
+bool TiledMesher::read_tile_file(int tile, bool halo, vector<tiled_seed> &seeds) {
+
+    seeds.clear();
+    FILE *file = fopen(get_tile_filename(tile, halo).c_str(), "rb");
+    if (file == nullptr) {
+        return true;    // no seed ended up in this tile
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    seeds.resize(file_size / sizeof(tiled_seed));
+    bool success = fread(seeds.data(), sizeof(tiled_seed), seeds.size(), file) == seeds.size();
+    fclose(file);
+
+    return success;
+}
+
+void TiledMesher::remove_tile_files() {
+    for (int tile = 0; tile < tiles_per_dim * tiles_per_dim; tile++) {
+        remove(get_tile_filename(tile, false).c_str());
+        remove(get_tile_filename(tile, true).c_str());
+    }
+}
+
+// bin the seeds first_id to first_id + n - 1 into their tile and into the halo of all tiles they are close to
+void TiledMesher::add_seeds(const Point *points, long long n, long long first_id) {
+
+    auto start = chrono::high_resolution_clock::now();
+
+    for (long long i = 0; i < n; i++) {
+
+        tiled_seed seed = {points[i].x, points[i].y, first_id + i};
+        int own_tile = tile_coord(seed.y) * tiles_per_dim + tile_coord(seed.x);
+        tile_buffers[own_tile].push_back(seed);
+        if (tile_buffers[own_tile].size() >= TILED_BUFFER_SEEDS) {
+            flush_buffer(own_tile, false);
+        }
+
+        for (int ty = tile_coord(seed.y - halo_width); ty <= tile_coord(seed.y + halo_width); ty++) {
+            for (int tx = tile_coord(seed.x - halo_width); tx <= tile_coord(seed.x + halo_width); tx++) {
+                int tile = ty * tiles_per_dim + tx;
+                if (tile == own_tile) {
+                    continue;
+                }
+                halo_buffers[tile].push_back(seed);
+                if (halo_buffers[tile].size() >= TILED_BUFFER_SEEDS) {
+                    flush_buffer(tile, true);
+                }
+            }
+        }
+    }
+    nr_seeds += n;
+
+    auto end = chrono::high_resolution_clock::now();
+    report.binning_time += chrono::duration<double>(end - start).count();
+}
+
+// mesh all tiles and write their cells to filename (format in TiledMesher.h). the tile files are removed afterwards
+bool TiledMesher::build(string filename) {
+
+    auto start = chrono::high_resolution_clock::now();
+
+    int nr_tiles = tiles_per_dim * tiles_per_dim;
+    bool success = true;
+    for (int tile = 0; tile < nr_tiles; tile++) {
+        success = flush_buffer(tile, false) && success;
+        success = flush_buffer(tile, true) && success;
+        vector<tiled_seed>().swap(tile_buffers[tile]);
+        vector<tiled_seed>().swap(halo_buffers[tile]);
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    report.binning_time += chrono::duration<double>(end - start).count();
+    start = end;
+
+    FILE *output = fopen(filename.c_str(), "wb");
+    if (!success || output == nullptr) {
+        cout << "could not write the tile files or open " << filename << " for writing" << endl;
+        if (output != nullptr) {
+            fclose(output);
+        }
+        return false;
+    }
+
+    // the header is written again at the end, when the number of cells is known
+    CellStreamHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CELL_STREAM_MAGIC, 8);
+    header.version = CELL_STREAM_VERSION;
+    fwrite(&header, 1, sizeof(header), output);
+
+    mutex output_mutex;
+    vector<char> tile_success(nr_tiles, 1);
+    int tiles_done = 0;
+
+    ThreadPool pool(n_threads);
+    vector<tiled_report> thread_reports(pool.nr_threads, tiled_report{0, 0, 0, 0, 0, 0, 0, 0});
+    pool.parallel_for(nr_tiles, 1, [&](int begin, int end, int thread_id) {
+        for (int tile = begin; tile < end; tile++) {
+
+            tile_success[tile] = mesh_tile(tile, output, output_mutex, thread_reports[thread_id]);
+
+            lock_guard<mutex> lock(output_mutex);
+            tiles_done++;
+            if (print_progress) {
+                cout << "tiles: " << tiles_done << "/" << nr_tiles << "\r";
+                cout.flush();
+            }
+        }
+    });
+    if (print_progress) {
+        cout << endl;
+    }
+
+    for (int t = 0; t < thread_reports.size(); t++) {
+        report.nr_cells += thread_reports[t].nr_cells;
+        report.nr_cell_entries += thread_reports[t].nr_cell_entries;
+        report.nr_halo_seeds += thread_reports[t].nr_halo_seeds;
+        report.nr_halo_growths += thread_reports[t].nr_halo_growths;
+        report.max_tile_seeds = max(report.max_tile_seeds, thread_reports[t].max_tile_seeds);
+        report.total_area += thread_reports[t].total_area;
+    }
+    for (int tile = 0; tile < nr_tiles; tile++) {
+        success = success && tile_success[tile];
+    }
+
+    header.nr_cells = report.nr_cells;
+    header.nr_cell_entries = report.nr_cell_entries;
+    fseek(output, 0, SEEK_SET);
+    fwrite(&header, 1, sizeof(header), output);
+    success = success && (ferror(output) == 0) && report.nr_cells == nr_seeds;
+    fclose(output);
+
+    remove_tile_files();
+
+    end = chrono::high_resolution_clock::now();
+    report.meshing_time += chrono::duration<double>(end - start).count();
+
+    return success;
+}
+
+// mesh one tile with its ghost seeds and write the cells of its own seeds. cells that seeds outside of the halo could
+// still clip are kept back and the tile is meshed again with a wider halo, until all cells are written
+bool TiledMesher::mesh_tile(int tile, FILE *output, mutex &output_mutex, tiled_report &tile_report) {
+
+    vector<tiled_seed> own;
+    if (!read_tile_file(tile, false, own)) {
+        return false;
+    }
+    if (own.empty()) {
+        return true;
+    }
+
+    int tx = tile % tiles_per_dim;
+    int ty = tile / tiles_per_dim;
+    double tile_width = 1.0 / tiles_per_dim;
+
+    vector<char> pending(own.size(), 1);
+    long long nr_pending = own.size();
+    double h = halo_width;
+    bool success = true;
+    double tile_area = 0;
+
+    vector<char> buffer;
+    buffer.reserve(TILED_OUTPUT_CHUNK + 4096);
+    auto put = [&buffer](const void *data, size_t size) {
+        const char *bytes = static_cast<const char *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    };
+    auto write_buffer = [&]() {
+        lock_guard<mutex> lock(output_mutex);
+        success = (fwrite(buffer.data(), 1, buffer.size(), output) == buffer.size()) && success;
+        buffer.clear();
+    };
+
+    for (int attempt = 0; nr_pending > 0; attempt++) {
+
+        // region of the unit square whose seeds are all known to this tile
+        TileRegion region(tx, ty, tile_width, h);
+
+        // ghost seeds: the halo file, for a wider halo the seeds of all tiles around that lie within the region
+        vector<tiled_seed> ghosts;
+        if (attempt == 0) {
+            success = read_tile_file(tile, true, ghosts) && success;
+        } else {
+            vector<tiled_seed> other;
+            for (int oy = tile_coord(region.y_min); oy <= tile_coord(region.y_max); oy++) {
+                for (int ox = tile_coord(region.x_min); ox <= tile_coord(region.x_max); ox++) {
+                    if (oy * tiles_per_dim + ox == tile) {
+                        continue;
+                    }
+                    success = read_tile_file(oy * tiles_per_dim + ox, false, other) && success;
+                    for (int k = 0; k < other.size(); k++) {
+                        if (region.contains(Point(other[k].x, other[k].y))) {
+                            ghosts.push_back(other[k]);
+                        }
+                    }
+                }
+            }
+        }
+
+        // own seeds first, then the ghosts, inserted along a hilbert curve so that the walks stay short
+        int n_own = own.size();
+        int n_local = n_own + ghosts.size();
+        vector<uint64_t> keys(n_local);
+        for (int k = 0; k < n_local; k++) {
+            const tiled_seed &seed = (k < n_own) ? own[k] : ghosts[k - n_own];
+            keys[k] = get_hilbert_key(Point(seed.x, seed.y));
+        }
+        vector<int> order = radix_sort_keys(keys);
+        vector<uint64_t>().swap(keys);
+
+        vector<Point> local_pts(n_local);
+        vector<long long> local_ids(n_local);
+        for (int k = 0; k < n_local; k++) {
+            const tiled_seed &seed = (order[k] < n_own) ? own[order[k]] : ghosts[order[k] - n_own];
+            local_pts[k] = Point(seed.x, seed.y);
+            local_ids[k] = seed.id;
+        }
+        vector<tiled_seed>().swap(ghosts);
+
+        tile_report.nr_halo_seeds += n_local - n_own;
+        tile_report.max_tile_seeds = max(tile_report.max_tile_seeds, static_cast<long long>(n_local));
+
+        VoronoiMesh local_mesh(local_pts);
+        local_mesh.print_progress = false;
+        if (n_local > 3) {
+            local_mesh.do_point_insertion();
+        } else {
+            local_mesh.construct_mesh();
+        }
+        vector<Point>().swap(local_pts);
+
+        for (int k = 0; k < n_local; k++) {
+
+            if (order[k] >= n_own || !pending[order[k]]) {
+                continue;
+            }
+
+            VoronoiCell &cell = local_mesh.vcells[k];
+            if (!region.covers(cell)) {
+                continue;
+            }
+
+            long long degree = cell.edges.size();
+            put(&local_ids[k], 8);
+            put(&cell.seed.x, 8);
+            put(&cell.seed.y, 8);
+            put(&degree, 8);
+            for (int e = 0; e < degree; e++) {
+                int neighbour = cell.edges[e].index2;
+                long long neighbour_id = (neighbour >= 0) ? local_ids[neighbour] : neighbour;
+                put(&neighbour_id, 8);
+            }
+            for (int e = 0; e < degree; e++) {
+                put(&cell.verticies[e].x, 8);
+                put(&cell.verticies[e].y, 8);
+            }
+            if (buffer.size() >= TILED_OUTPUT_CHUNK) {
+                write_buffer();
+            }
+
+            pending[order[k]] = 0;
+            nr_pending--;
+            tile_report.nr_cells += 1;
+            tile_report.nr_cell_entries += degree;
+            tile_area += cell.get_area();
+        }
+
+        if (nr_pending > 0) {
+            h = TileRegion::widen_halo(h, tile_width);
+            tile_report.nr_halo_growths += 1;
+        }
+    }
+
+    write_buffer();
+    tile_report.total_area += tile_area;
+    return success;
+}
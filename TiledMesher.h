@@ -0,0 +1,84 @@
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include "Point.h"
+#include "VoronoiMesh.h"
+using namespace std;
+
+#ifndef TiledMesher_h
+#define TiledMesher_h
+
+// streamed cell file (.vmcs): header followed by nr_cells records in the order the tiles finish, every field 8 bytes
+//   int64 id, double seed x, double seed y, int64 degree,
+//   degree x int64 neighbour id (negative: boundary -2..-5), degree x (double x, double y) vertex
+// vertex j lies between the edges to neighbour j and neighbour j+1 (clockwise, like the edges of a VoronoiCell).
+// verticies are stored with every cell they belong to, so a cell can be written without waiting for its neighbours
+struct CellStreamHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t nr_cells;
+    uint64_t nr_cell_entries;
+};
+
+const char CELL_STREAM_MAGIC[8] = {'V', 'M', 'P', 'C', 'E', 'L', 'L', 'S'};
+const uint32_t CELL_STREAM_VERSION = 1;
+
+// seed as stored in the tile files
+struct tiled_seed
+    {
+        double x;
+        double y;
+        long long id;
+    };
+
+// outcome of TiledMesher::build
+struct tiled_report
+    {
+        long long nr_cells;
+        long long nr_cell_entries;
+        long long nr_halo_seeds;        // ghost seeds meshed on top of the own ones, summed over all tiles
+        long long nr_halo_growths;      // times a tile had to be meshed again with a wider halo
+        long long max_tile_seeds;       // most seeds (own and ghost) in one tile mesh
+        double total_area;              // of all written cells, 1 if the tiles cover the unit square without gaps
+        double binning_time;            // in seconds
+        double meshing_time;
+    };
+
+// out of core mesh generation: the seeds are binned into tiles_per_dim x tiles_per_dim tile files on disk (plus the
+// ghost seeds within halo_width of every tile) and the tiles are meshed one after another, n_threads at a time. the
+// finished cells of a tile go straight into the output file and the tile mesh is freed, so the memory is bounded by
+// the size of a tile and not by the number of seeds. seeds need not fit into memory at once, add_seeds can be called
+// chunk by chunk. a cell is only written once every seed that could clip it is in its tile mesh, otherwise the tile is
+// meshed again with a twice as wide halo (read from the neighbouring tile files), see TileRegion
+class TiledMesher {
+
+public:
+    TiledMesher(int tiles_per_dim, double halo_width, string work_dir = "files", int n_threads = 1);
+    ~TiledMesher();
+    int tiles_per_dim;
+    double halo_width;
+    string work_dir;
+    int n_threads;
+    bool print_progress;
+    tiled_report report;
+    void add_seeds(const Point *points, long long n, long long first_id);
+    bool build(string filename);
+    static int get_tiles_per_dim(long long n_seeds, long long seeds_per_tile);
+
+private:
+    vector<vector<tiled_seed>> tile_buffers;
+    vector<vector<tiled_seed>> halo_buffers;
+    long long nr_seeds;
+    int tile_coord(double x);
+    string get_tile_filename(int tile, bool halo);
+    bool flush_buffer(int tile, bool halo);
+    bool read_tile_file(int tile, bool halo, vector<tiled_seed> &seeds);
+    bool mesh_tile(int tile, FILE *output, mutex &output_mutex, tiled_report &tile_report);
+    void remove_tile_files();
+
+};
+
+#endif
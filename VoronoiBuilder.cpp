@@ -0,0 +1,92 @@
+#include <algorithm>
+#include "VoronoiBuilder.h"
+
+VoronoiBuilder::VoronoiBuilder(int algorithm, int n_threads) : vmesh(vector<Point>()) {
+    this->algorithm = algorithm;
+    this->n_threads = n_threads;
+    optimize_memory = false;
+    brio_insertion = false;
+    cmesh_up_to_date = true;
+    vmesh.print_progress = false;
+}
+
+VoronoiBuilder::~VoronoiBuilder() {}
+
+// build the mesh of n seeds given as interleaved coordinates x0, y0, x1, y1, ...
+void VoronoiBuilder::build(const double *xy, int n) {
+
+    vmesh.set_points(xy, n);
+    build_mesh();
+}
+
+// build the mesh of n seeds, cell i belongs to points[i]
+void VoronoiBuilder::build(const Point *points, int n) {
+
+    vmesh.set_points(points, n);
+    build_mesh();
+}
+
+// build the mesh of the seeds that were just set
+void VoronoiBuilder::build_mesh() {
+
+    vmesh.brio_insertion = brio_insertion;
+    vmesh.build(algorithm, n_threads, optimize_memory);
+
+    // the flat arrays are only converted when they are asked for
+    cmesh_up_to_date = false;
+}
+
+// the mesh of the last build as cells (for the checks and the output of the program)
+VoronoiMesh &VoronoiBuilder::get_voronoi_mesh() {
+    return vmesh;
+}
+
+// the mesh of the last build as flat arrays, valid until the next build
+const CompactMesh &VoronoiBuilder::get_mesh() {
+
+    if (!cmesh_up_to_date) {
+        cmesh.assign(vmesh);
+        cmesh_up_to_date = true;
+    }
+    return cmesh;
+}
+
+int VoronoiBuilder::get_nr_cells() {
+    return get_mesh().get_nr_cells();
+}
+
+int VoronoiBuilder::get_nr_vertices() {
+    return get_mesh().vertices.size();
+}
+
+// number of (vertex, neighbour) entries of all cells
+int VoronoiBuilder::get_nr_cell_entries() {
+    return get_mesh().cell_vertices.size();
+}
+
+// copy the mesh of the last build into arrays of the caller with the sizes
+//   vertex_xy:       2 * get_nr_vertices()
+//   cell_offsets:    get_nr_cells() + 1
+//   cell_vertices:   get_nr_cell_entries()
+//   cell_neighbours: get_nr_cell_entries()
+// arrays passed as nullptr are skipped
+void VoronoiBuilder::copy_mesh(double *vertex_xy, int *cell_offsets, int *cell_vertices, int *cell_neighbours) {
+
+    const CompactMesh &mesh = get_mesh();
+
+    if (vertex_xy != nullptr) {
+        for (int i = 0; i < mesh.vertices.size(); i++) {
+            vertex_xy[2*i] = mesh.vertices[i].x;
+            vertex_xy[2*i + 1] = mesh.vertices[i].y;
+        }
+    }
+    if (cell_offsets != nullptr) {
+        copy(mesh.cell_offsets.begin(), mesh.cell_offsets.end(), cell_offsets);
+    }
+    if (cell_vertices != nullptr) {
+        copy(mesh.cell_vertices.begin(), mesh.cell_vertices.end(), cell_vertices);
+    }
+    if (cell_neighbours != nullptr) {
+        copy(mesh.cell_neighbours.begin(), mesh.cell_neighbours.end(), cell_neighbours);
+    }
+}
@@ -0,0 +1,46 @@
+#include <vector>
+#include "Point.h"
+#include "VoronoiMesh.h"
+#include "CompactMesh.h"
+using namespace std;
+
+#ifndef VoronoiBuilder_h
+#define VoronoiBuilder_h
+
+// entry point of the vmp library: builds the mesh of seeds in the unit square given in a buffer owned by the caller
+// and hands out the topology as the flat arrays of a CompactMesh (see CompactMesh.h), without any file I/O.
+// one builder is meant to be kept and reused, e.g. once per timestep of a simulation: all arrays keep their
+// capacity from build to build and cell pool slabs that ran empty are given back after every build. the seeds are
+// copied once into the mesh, the buffer is not referenced afterwards.
+//
+//   VoronoiBuilder builder(1, 4);
+//   builder.build(xy, n);                      // xy = x0, y0, x1, y1, ...
+//   const CompactMesh &mesh = builder.get_mesh();
+//
+class VoronoiBuilder {
+
+public:
+    VoronoiBuilder(int algorithm = 1, int n_threads = 1);
+    ~VoronoiBuilder();
+    int algorithm;              // 0: halfplane intersection, 1: point insertion, 2: dual of the Delaunay triangulation, 3: Fortune sweepline, 4: knn clipping
+    int n_threads;
+    bool optimize_memory;       // compact the cells after the build (VoronoiMesh::optimize_mesh_memory), off by default
+    bool brio_insertion;        // serial point insertion in randomized order, for seeds in arbitrary order
+    void build(const double *xy, int n);
+    void build(const Point *points, int n);
+    VoronoiMesh &get_voronoi_mesh();
+    const CompactMesh &get_mesh();
+    int get_nr_cells();
+    int get_nr_vertices();
+    int get_nr_cell_entries();
+    void copy_mesh(double *vertex_xy, int *cell_offsets, int *cell_vertices, int *cell_neighbours);
+
+private:
+    VoronoiMesh vmesh;
+    CompactMesh cmesh;
+    bool cmesh_up_to_date;
+    void build_mesh();
+
+};
+
+#endif
@@ -1,9 +1,12 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 #include "VoronoiCell.h"
+#include "RobustPredicates.h"
 #include "Point.h"
 #include "Halfplane.h"
+#include "HalfplaneBatch.h"
 
 VoronoiCell::VoronoiCell() {}
 
@@ -55,29 +58,32 @@ void VoronoiCell::intersect_two_halfplanes(Halfplane &hp1, Halfplane &hp2, vecto
 
 
     }
-    // if D = 0 -> check if Dx and Dy are 0 -> if: infinite sol, not: no sol
+    // if D = 0 -> check if Dx and Dy are 0 -> if: infinite sol, not: no sol (parallel halfplanes, normal for seeds
+    // on a line with the seed like on a grid, there is nothing to add)
     else if (D == 0)
     {
         if (Dx == 0 && Dy == 0) {
             cout << "infinite solutions: that shouldnt happen" << endl;
-            
-        } else if (!(hp1.boundary || hp2.boundary)) {
-            cout << "no solution while trying to intersect two halfplanes" << endl;
-                    
         }
     }
     
     
 }
 
+// boundary of the unit square as halfplane: -2: y=1, -3: x=1, -4: y=0, -5: x=0
+Halfplane VoronoiCell::get_boundary_halfplane(int boundary_index) {
+
+    static const Point outside[4] = {Point(0.5,1.5), Point(1.5, 0.5), Point(0.5,-0.5), Point(-0.5,0.5)};
+    return Halfplane(Point(0.5,0.5), outside[-2 - boundary_index], -1, boundary_index, true);
+}
+
 // generate all halfplanes + boundary halfplanes
-void VoronoiCell::generate_halfplane_vector(vector<Point> pts,  vector<int> indices) {
+void VoronoiCell::generate_halfplane_vector(const vector<Point> &pts, const vector<int> &indices) {
     
     // generate boundary halfplanes
-    halfplanes.push_back(Halfplane(Point(0.5,0.5), Point(0.5,1.5), -1, -2, true));
-    halfplanes.push_back(Halfplane(Point(0.5,0.5), Point(1.5, 0.5), -1, -3,true));
-    halfplanes.push_back(Halfplane(Point(0.5,0.5), Point(0.5,-0.5), -1, -4, true));
-    halfplanes.push_back(Halfplane(Point(0.5,0.5), Point(-0.5,0.5), -1, -5, true));
+    for (int boundary_index = -2; boundary_index >= -5; boundary_index--) {
+        halfplanes.push_back(get_boundary_halfplane(boundary_index));
+    }
 
     // generate usual halfplanes
     for (int i = 0; i<pts.size(); i++) {
@@ -114,8 +120,23 @@ double VoronoiCell::get_signed_angle(Point u, Point v) {
     return angle;
 }
 
+// exact comparison of the intersections of the bisectors of seed and the sites a and b with the bisector of seed and
+// current (the current edge): true if the one of a comes strictly first in direction of hp_vec. the circle through seed
+// and current centered on the intersection of b contains a exactly if a comes first and lies on the side of the edge
+// hp_vec points away from, or if it comes later and lies on the other side
+static bool intersection_before(const PredicateSite &seed, const PredicateSite &current, const PredicateSite &a, const PredicateSite &b) {
+
+    int orientation_a = orient2d_sign(seed, current, a);
+    int orientation_b = orient2d_sign(seed, current, b);
+    int in_circle = incircle_sign(seed, current, b, a);
+    if (in_circle == 0 || orientation_a == 0 || orientation_b == 0) {
+        return false;
+    }
+    return (in_circle * orientation_b > 0) == (orientation_a < 0);
+}
+
 // algorithm to construct the cell
-void VoronoiCell::construct_cell(vector<Point> pts, vector<int> indices) {
+void VoronoiCell::construct_cell(const vector<Point> &pts, const vector<int> &indices, MeshStats *stats) {
 
     // generate all halfplanes
     generate_halfplane_vector(pts, indices);
@@ -130,6 +151,10 @@ void VoronoiCell::construct_cell(vector<Point> pts, vector<int> indices) {
     // intitalize last_vertex  for the first time
     Point last_vertex = current_hp.midpoint;
 
+    // structure of arrays copy of the halfplanes for the intersection kernel (kept per thread, refilled per cell)
+    static thread_local HalfplaneBatch batch;
+    batch.assign(halfplanes.data(), halfplanes.size());
+
     int counter = 0;
     // step by step generate voronoi cell
     do {
@@ -141,68 +166,103 @@ void VoronoiCell::construct_cell(vector<Point> pts, vector<int> indices) {
     double smallest_pos_dist = 42;
     Halfplane next_hp;
     Point vertex;
-    bool need_to_check_for_degeneracy = false;
 
-    vector<intersection> intersections;
-
-    //intersect halfplanes for current_hp
-    for (int j = 0; j<halfplanes.size(); j++) {
-            if (!(current_hp.index2 == halfplanes[j].index2)) {
-                intersect_two_halfplanes(current_hp, halfplanes[j], intersections);
-            }
-        }
-
-    // find intersection with smallest positive signed distance to last_vertex
-    for (int i = 0; i<intersections.size(); i++) {
+    // one pass over all halfplanes: a closest intersection clearly ahead of the last vertex and of all others is the
+    // next vertex, otherwise there may be a degenerate vertex or a very short edge and the decision is made exactly
+    batch_intersection closest = batch.find_smallest_pos_intersect(current_hp, last_vertex_dist_to_midpoint, -0.0000001, smallest_pos_dist,
+                                                                   current_hp.index2, last_vertex_index2);
+    bool clear_winner = closest.index >= 0 && closest.rel_dist > 0.0000001 && !(closest.second_rel_dist - 0.000001 < closest.rel_dist);
+    if (stats != nullptr) {
+        VMP_STAT_ADD(*stats, halfplane_intersections, batch.size);
+    }
 
-        // calculate signed relative distance
-        double rel_dist =  intersections[i].dist_to_midpoint - last_vertex_dist_to_midpoint;
+    if (clear_winner) {
+        next_hp = halfplanes[closest.index];
+        vertex = closest.intersect_pt;
+    } else {
 
-        bool same_vertex = ((*intersections[i].intersecting_with).index2 == last_vertex_index2);
+        vector<intersection> intersections;
+        if (stats != nullptr) {
+            VMP_STAT_ADD(*stats, halfplane_intersections, halfplanes.size());
+            VMP_STAT_ADD(*stats, degeneracy_checks, 1);
+        }
 
-        // if distance <= smallest_pos_distance and positive replace intersection with closer one
-        if (rel_dist <= smallest_pos_dist && rel_dist > 0.0000001 && !same_vertex) {
-            // check if there could be a degenerate case
-            if (rel_dist - 0.000001 < smallest_pos_dist && rel_dist + 0.000001 > smallest_pos_dist) {
-                need_to_check_for_degeneracy = true;
+        //intersect halfplanes for current_hp
+        for (int j = 0; j<halfplanes.size(); j++) {
+                if (!(current_hp.index2 == halfplanes[j].index2)) {
+                    intersect_two_halfplanes(current_hp, halfplanes[j], intersections);
+                }
             }
-            // update nearest intersection candidate
-            smallest_pos_dist = rel_dist;
-            next_hp = *intersections[i].intersecting_with;
-            vertex = intersections[i].intersect_pt;
 
-        
+        // the sites of the halfplanes for the predicates (the halfplanes are the boundaries and then pts without
+        // the seed itself)
+        int self_position = find(indices.begin(), indices.end(), index) - indices.begin();
+        auto get_site = [&](const Halfplane &hp) {
+            if (hp.boundary) {
+                return make_mirror_site(seed, hp.index2);
+            }
+            int position = &hp - halfplanes.data() - 4;
+            if (position >= self_position) {
+                position += 1;
+            }
+            return make_site(pts[position], hp.index2);
+        };
+        PredicateSite cell_site = make_site(seed, index);
+        PredicateSite current_site = cell_site;
+        PredicateSite last_site = cell_site;
+        for (int j = 0; j<halfplanes.size(); j++) {
+            if (halfplanes[j].index2 == current_hp.index2) {
+                current_site = get_site(halfplanes[j]);
+            }
+            if (halfplanes[j].index2 == last_vertex_index2) {
+                last_site = get_site(halfplanes[j]);
+            }
         }
-    }
-     
-    // if degeneracy possible check for it and choose the correct halfplane
-    if (need_to_check_for_degeneracy) {
-        vector<Halfplane> deg_hp_list;
-        
+
+        // candidates are the intersections exactly ahead of the last vertex (ahead of the midpoint for the first one)
+        vector<int> candidates;
         for (int i = 0; i<intersections.size(); i++) {
-            
+
             // calculate signed relative distance
             double rel_dist =  intersections[i].dist_to_midpoint - last_vertex_dist_to_midpoint;
-            
-            // put degenerate cases into vector
-            if (rel_dist == smallest_pos_dist) {
-                deg_hp_list.push_back(*intersections[i].intersecting_with);
-            }
-
+            const Halfplane &hp = *intersections[i].intersecting_with;
 
+            if (hp.index2 == last_vertex_index2 || !(rel_dist > -0.0000001)) {
+                continue;
+            }
+            bool ahead = (last_vertex_index2 == -42) ? rel_dist > 0 : intersection_before(cell_site, current_site, last_site, get_site(hp));
+            if (ahead) {
+                candidates.push_back(i);
+                smallest_pos_dist = min(smallest_pos_dist, rel_dist);
+            }
         }
 
-        // calculate the signed angle between current_hp vec and deg_hp_list vec
-        double max_angle = 0;
-
-        for (int i = 0; i<deg_hp_list.size(); i++) {
+        // of the candidates within the tolerance of the smallest distance the closest ones are found exactly, of
+        // exactly tied ones (a vertex with more than three cells) the halfplane with the highest signed angle is taken
+        double max_angle = -42;
+        for (int i = 0; i<candidates.size(); i++) {
 
-            double angle = get_signed_angle(current_hp.hp_vec, deg_hp_list[i].hp_vec);
+            const intersection &candidate = intersections[candidates[i]];
+            if (!(candidate.dist_to_midpoint - last_vertex_dist_to_midpoint < smallest_pos_dist + 0.000001)) {
+                continue;
+            }
+            PredicateSite candidate_site = get_site(*candidate.intersecting_with);
+            bool is_closest = true;
+            for (int j = 0; j<candidates.size() && is_closest; j++) {
+                const intersection &other = intersections[candidates[j]];
+                is_closest = (j == i) || !(other.dist_to_midpoint - last_vertex_dist_to_midpoint < smallest_pos_dist + 0.000001)
+                          || !intersection_before(cell_site, current_site, get_site(*other.intersecting_with), candidate_site);
+            }
+            if (!is_closest) {
+                continue;
+            }
 
-            // choose the hp with highest signed angle as the next hp
+            // calculate the signed angle between current_hp vec and the candidate
+            double angle = get_signed_angle(current_hp.hp_vec, candidate.intersecting_with->hp_vec);
             if (angle > max_angle) {
                 max_angle = angle;
-                next_hp = deg_hp_list[i];
+                next_hp = *candidate.intersecting_with;
+                vertex = candidate.intersect_pt;
             }
         }
     }
@@ -233,8 +293,84 @@ void VoronoiCell::construct_cell(vector<Point> pts, vector<int> indices) {
 
 }
 
+// construct the cell only from seeds near by: add rings of grid buckets until the security radius proves the cell is closed
+void VoronoiCell::construct_cell_local(const vector<Point> &pts, const SeedGrid &grid, MeshStats *stats) {
+
+    int bx = grid.get_bucket_coord(seed.x);
+    int by = grid.get_bucket_coord(seed.y);
+
+    vector<int> candidates;
+    vector<Point> candidate_pts;
+
+    // start with the bucket of the seed and its direct neighbours
+    grid.get_ring(bx, by, 0, candidates);
+    int ring = 1;
+
+    while (true) {
+
+        grid.get_ring(bx, by, ring, candidates);
+
+        candidate_pts.clear();
+        for (int i = 0; i < candidates.size(); i++) {
+            candidate_pts.push_back(pts[candidates[i]]);
+        }
+
+        construct_cell(candidate_pts, candidates, stats);
+
+        // a seed further away than twice the distance to the farthest vertex can not clip the cell
+        // (the boundary halfplanes are always part of the set, so the cell is closed from the start)
+        if (2 * get_security_radius() <= grid.get_covered_radius(ring) || grid.covers_all(bx, by, ring)) {
+            break;
+        }
+
+        // not provably closed yet -> add next ring and construct again
+        edges.clear();
+        verticies.clear();
+        ring += 1;
+    }
+
+}
+
+// construct the cell from its neighbours in clockwise order (index2 of the edges: seed index or boundary index), as
+// given by the Delaunay triangulation. vertex i is the intersection of edge i and edge i+1
+void VoronoiCell::construct_cell_from_neighbours(const vector<Point> &pts, const vector<int> &neighbours, vector<intersection> &buffer) {
+
+    edges.clear();
+    verticies.clear();
+
+    for (int i = 0; i < neighbours.size(); i++) {
+        if (neighbours[i] < 0) {
+            edges.push_back(get_boundary_halfplane(neighbours[i]));
+        } else {
+            edges.push_back(Halfplane(seed, pts[neighbours[i]], index, neighbours[i]));
+        }
+    }
+
+    int n = edges.size();
+    for (int i = 0; i < n; i++) {
+        buffer.clear();
+        intersect_two_halfplanes(edges[i], edges[(i+1)%n], buffer);
+        verticies.push_back(buffer.empty() ? edges[i].midpoint : buffer[0].intersect_pt);
+    }
+}
+
+// largest distance between the seed and a vertex of the cell
+double VoronoiCell::get_security_radius() {
+
+    double max_dist = 0;
+
+    for (int i = 0; i < verticies.size(); i++) {
+        double dist = sqrt((verticies[i].x - seed.x)*(verticies[i].x - seed.x) + (verticies[i].y - seed.y)*(verticies[i].y - seed.y));
+        if (dist > max_dist) {
+            max_dist = dist;
+        }
+    }
+
+    return max_dist;
+}
+
 // check all vertecies of the cell for equidistance conditions
-bool VoronoiCell::check_equidistance_condition(vector<Point> seeds) {
+bool VoronoiCell::check_equidistance_condition(const vector<Point> &seeds) {
 
     bool correct_cell = true;
 
@@ -288,6 +424,96 @@ bool VoronoiCell::check_equidistance_condition(vector<Point> seeds) {
     return correct_cell;
 }
 
+// same check, but only the seeds with the given indices are candidates for the closest seeds of a vertex
+bool VoronoiCell::check_equidistance_condition(const vector<Point> &seeds, const vector<int> &seed_indices) {
+
+    bool correct_cell = true;
+
+    for (int i = 0; i < verticies.size(); i++) {
+
+        // only check vertex if it is not on boundary within error margin
+        bool condition = verticies[i].x > 0.000000000000001 && verticies[i].y > 0.000000000000001 && verticies[i].x < 0.999999999999999 && verticies[i].y < 0.999999999999999;
+
+        if (condition) {
+
+            int nr_equidist_pts = 0;
+
+            double min_dist = 42;
+
+            // determine minimum distance
+            for (int j = 0; j < seed_indices.size(); j++) {
+
+                const Point &s = seeds[seed_indices[j]];
+                double dist = sqrt((s.x - verticies[i].x)*(s.x - verticies[i].x) + (s.y - verticies[i].y)*(s.y - verticies[i].y));
+
+                if (dist < min_dist) {
+                    min_dist = dist;
+                }
+            }
+
+            // search for seeds with minimum distance
+            for (int j = 0; j < seed_indices.size(); j++) {
+
+                const Point &s = seeds[seed_indices[j]];
+                double dist = sqrt((s.x - verticies[i].x)*(s.x - verticies[i].x) + (s.y - verticies[i].y)*(s.y - verticies[i].y));
+
+                if (min_dist - 0.000000000000001 < dist && dist < min_dist + 0.000000000000001) {
+                    nr_equidist_pts += 1;
+                }
+            }
+
+            if (nr_equidist_pts < 3) {
+                correct_cell = false;
+            }
+
+        }
+
+    }
+
+    return correct_cell;
+}
+
+// check that no seed lies inside the circle around a vertex that passes through the seed of the cell (empty circle
+// property of the delaunay triangulation). the seeds near a vertex are taken from the grid (buffer is reused)
+bool VoronoiCell::check_empty_circle_condition(const vector<Point> &seeds, const SeedGrid &grid, vector<int> &buffer) {
+
+    for (int i = 0; i < verticies.size(); i++) {
+
+        const Point &v = verticies[i];
+
+        // vertices on the boundary are not circumcenters of three seeds
+        bool condition = v.x > 0.000000000000001 && v.y > 0.000000000000001 && v.x < 0.999999999999999 && v.y < 0.999999999999999;
+        if (!condition) {
+            continue;
+        }
+
+        double radius = sqrt((seed.x - v.x)*(seed.x - v.x) + (seed.y - v.y)*(seed.y - v.y));
+
+        // all seeds closer than radius lie in the rings of buckets up to this one
+        int bx = grid.get_bucket_coord(v.x);
+        int by = grid.get_bucket_coord(v.y);
+        int max_ring = static_cast<int>(ceil(radius / grid.bucket_width));
+
+        buffer.clear();
+        for (int ring = 0; ring <= max_ring; ring++) {
+            grid.get_ring(bx, by, ring, buffer);
+            if (grid.covers_all(bx, by, ring)) {
+                break;
+            }
+        }
+
+        for (int j = 0; j < buffer.size(); j++) {
+            const Point &s = seeds[buffer[j]];
+            double dist = sqrt((s.x - v.x)*(s.x - v.x) + (s.y - v.y)*(s.y - v.y));
+            if (dist < radius - 0.000000000000001) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 // function to calculate the area of the voronoi cell 
 double VoronoiCell::get_area() {
 
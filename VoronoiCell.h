@@ -1,6 +1,9 @@
 #include <vector>
 #include "Point.h"
 #include "Halfplane.h"
+#include "SeedGrid.h"
+#include "CellPool.h"
+#include "MeshStats.h"
 
 #ifndef VoronoiCell_h
 #define VoronoiCell_h
@@ -12,25 +15,39 @@ struct intersection
         double dist_to_midpoint; //distance signed relative to half_plane_vec
     };
 
+// polygon storage of the cells, comes from the CellPool unless it is switched off
+typedef vector<Halfplane, CellAllocator<Halfplane>> EdgeList;
+typedef vector<Point, CellAllocator<Point>> VertexList;
+
 class VoronoiCell {
 
 public:
     VoronoiCell();
     VoronoiCell(Point in_seed, int index);
+    VoronoiCell(const VoronoiCell &other) = default;
+    VoronoiCell(VoronoiCell &&other) = default;
+    VoronoiCell &operator=(const VoronoiCell &other) = default;
+    VoronoiCell &operator=(VoronoiCell &&other) = default;
     ~VoronoiCell();
     int index;
     Point seed;
     vector<Halfplane> halfplanes;
-    vector<Halfplane> edges;
-    vector<Point> verticies;
+    EdgeList edges;
+    VertexList verticies;
     void intersect_two_halfplanes(Halfplane &hp1, Halfplane &hp2, vector<intersection> &intersections);
-    void construct_cell(vector<Point> pts, vector<int> indices);
-    bool check_equidistance_condition(vector<Point> seeds);
+    void construct_cell(const vector<Point> &pts, const vector<int> &indices, MeshStats *stats = nullptr);
+    void construct_cell_local(const vector<Point> &pts, const SeedGrid &grid, MeshStats *stats = nullptr);
+    void construct_cell_from_neighbours(const vector<Point> &pts, const vector<int> &neighbours, vector<intersection> &buffer);
+    double get_security_radius();
+    bool check_equidistance_condition(const vector<Point> &seeds);
+    bool check_equidistance_condition(const vector<Point> &seeds, const vector<int> &seed_indices);
+    bool check_empty_circle_condition(const vector<Point> &seeds, const SeedGrid &grid, vector<int> &buffer);
     double get_area();
-    void generate_halfplane_vector(vector<Point> pts, vector<int> indices);
+    void generate_halfplane_vector(const vector<Point> &pts, const vector<int> &indices);
     double get_signed_angle(Point u, Point v);
     long long calculate_cell_memory(bool use_capacity);
     Point get_centroid();
+    static Halfplane get_boundary_halfplane(int boundary_index);
     
 private:
     void search_hp_closest_to_seed(Halfplane &first_hp);
@@ -1,429 +1,792 @@
 #include "VoronoiMesh.h"
+#include "ThreadPool.h"
+#include "SpaceFillingCurve.h"
+#include "CompactMesh.h"
+#include "DelaunayTriangulation.h"
+#include "FortuneSweep.h"
+#include "ClipPolygon.h"
+#include "TileRegion.h"
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <iostream>
 #include <set>
+#include <algorithm>
+#include <cmath>
+#ifdef VMP_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 VoronoiMesh::VoronoiMesh(vector<Point> points) {
     pts = points;
     total_steps = 0;
+    max_steps = 0;
     total_frame_counter = 0;
+    print_progress = true;
+    brio_insertion = false;
+    triangulation_memory = 0;
     //vcells.reserve(pts.size());
 }
 
 VoronoiMesh::~VoronoiMesh() {}
 
-// construct all cells using Halfplane Intersection Algorithm
-void VoronoiMesh::construct_mesh() {
+// replace the seeds and drop the old mesh, the vectors keep their capacity for the next build
+void VoronoiMesh::set_points(const Point *points, int n) {
+    pts.assign(points, points + n);
+    vcells.clear();
+    total_steps = 0;
+    max_steps = 0;
+    stats.reset();
+}
+
+// same for interleaved coordinates x0, y0, x1, y1, ..., read straight into pts
+void VoronoiMesh::set_points(const double *xy, int n) {
+    pts.resize(n);
+    for (int i = 0; i < n; i++) {
+        pts[i] = Point(xy[2*i], xy[2*i + 1]);
+    }
+    vcells.clear();
+    total_steps = 0;
+    max_steps = 0;
+    stats.reset();
+}
 
-    vector<int> indices;
+// construct the mesh of pts with algorithm 0 (halfplane intersection), 1 (point insertion), 2 (dual of the Delaunay
+// triangulation), 3 (sweepline) or 4 (clipping by the nearest seeds), in parallel if n_threads > 1. optimize_memory drops the spare capacity of the
+// cells afterwards (see optimize_mesh_memory)
+void VoronoiMesh::build(int algorithm, int n_threads, bool optimize_memory) {
 
-    for (int i = 0; i < pts.size(); i++) {
-        indices.push_back(i);
+    if (algorithm == 0) {
+        if (n_threads == 1) {
+            construct_mesh();                       // <-- O(n) scaling half plane intersection with seed grid
+        } else {
+            construct_mesh_parallel(n_threads);     // <-- same, cells built concurrently
+        }
+    } else if (algorithm == 2) {
+        construct_mesh_delaunay(n_threads);         // <-- dual of the Bowyer-Watson Delaunay triangulation
+    } else if (algorithm == 3) {
+        construct_mesh_sweepline(n_threads);        // <-- O(nlogn) Fortune sweepline for any order of the seeds
+    } else if (algorithm == 4) {
+        construct_mesh_knn(n_threads);              // <-- every cell clipped on its own by its k nearest seeds
+    } else {
+        if (pts.size() <= 3) {
+            construct_mesh();                       // <-- point insertion starts from a mesh of three seeds
+        } else if (n_threads == 1 && brio_insertion) {
+            do_brio_point_insertion();              // <-- same in a randomized order, independent of the order of pts
+        } else if (n_threads == 1) {
+            do_point_insertion();                   // <-- O(nlogn) scaling point insertion algoithm
+        } else {
+            do_parallel_point_insertion(n_threads); // <-- same on tiles with ghost seeds, stitched together
+        }
+    }
+
+    // with the cell pool: move all polygons into one contiguous run of slabs
+    if (optimize_memory) {
+        optimize_mesh_memory();
     }
 
+    // the slabs of the previous mesh and of the threads of this build that ran empty
+    CellPool::release_empty_slabs();
+}
+
+// construct all cells using Halfplane Intersection Algorithm
+void VoronoiMesh::construct_mesh() {
+
+    // bucket the seeds so that every cell only intersects halfplanes of nearby seeds
+    SeedGrid grid(pts, 2);
+
+    VMP_STAT_TIMER_START(construction_timer);
     for (int i = 0; i < pts.size(); i++) {
 
         // construct individual cell and add to vcells vector        
         VoronoiCell vcell(pts[i], i);
-        vcell.construct_cell(pts, indices);
+        vcell.construct_cell_local(pts, grid, &stats);
         vcells.push_back(vcell);
     }
+    VMP_STAT_TIMER_STOP(stats, cell_construction_time, construction_timer);
 
 }
 
-// find cell in which the point is in
-int VoronoiMesh::find_cell_index(Point point) {
-    
-    // guess as the cell im in the last generated cell
-    VoronoiCell current_cell = vcells.back();
-    double new_cell_index = current_cell.index;
-    bool found_cell = true;
+// construct all cells using Halfplane Intersection Algorithm on n_threads threads (same result as construct_mesh)
+void VoronoiMesh::construct_mesh_parallel(int n_threads) {
 
-    // search for cell
-    do {
+    SeedGrid grid(pts, 2);
 
-        // current distance
-        double current_cell_dist = sqrt((point.x - current_cell.seed.x)*(point.x - current_cell.seed.x) + (point.y - current_cell.seed.y)*(point.y - current_cell.seed.y));
-        double new_cell_dist = current_cell_dist;
-        found_cell = true;
+    // every cell only reads pts and writes its own slot -> presize vcells so threads never touch the same memory
+    vcells.clear();
+    vcells.resize(pts.size());
 
-        // try to reduce distance step
-        for (int i = 0; i<current_cell.edges.size(); i++) {
-
-            int index = current_cell.edges[i].index2;
-
-            if (index >= 0) {
-                double dist = sqrt((point.x - pts[index].x)*(point.x - pts[index].x) + 
-                                    (point.y - pts[index].y)*(point.y - pts[index].y));
-                if (dist < new_cell_dist) {
-                    new_cell_dist = dist;
-                    new_cell_index = index;
-                    found_cell = false;
-                }
-            }
+    ThreadPool pool(n_threads);
+    vector<MeshStats> thread_stats(pool.nr_threads);
+    pool.parallel_for(pts.size(), 0, [&](int begin, int end, int thread_id) {
+        VMP_STAT_TIMER_START(construction_timer);
+        for (int i = begin; i < end; i++) {
+            VoronoiCell vcell(pts[i], i);
+            vcell.construct_cell_local(pts, grid, &thread_stats[thread_id]);
+            vcells[i] = std::move(vcell);
         }
+        VMP_STAT_TIMER_STOP(thread_stats[thread_id], cell_construction_time, construction_timer);
+    });
+    for (int t = 0; t < thread_stats.size(); t++) {
+        stats.merge(thread_stats[t]);
+    }
+
+}
 
-        current_cell = vcells[new_cell_index];
+// construct all cells as the dual of the Delaunay triangulation (Bowyer-Watson, serial), the cells are built from the
+// triangles around their seed on n_threads threads
+void VoronoiMesh::construct_mesh_delaunay(int n_threads) {
 
-        total_steps += 1;
-    } while (!found_cell);
+    vector<int> order;
+    if (brio_insertion) {
+        order = get_brio_order(pts);
+    } else {
+        order.resize(pts.size());
+        for (int i = 0; i < pts.size(); i++) {
+            order[i] = i;
+        }
+    }
 
+    DelaunayTriangulation triangulation(pts, order, &stats);
+    total_steps = triangulation.total_steps;
+    max_steps = triangulation.max_steps;
+    triangulation_memory = triangulation.calculate_memory(true);
+
+    vcells.clear();
+    vcells.resize(pts.size());
+
+    ThreadPool pool(n_threads);
+    vector<MeshStats> thread_stats(pool.nr_threads);
+    pool.parallel_for(pts.size(), 0, [&](int begin, int end, [[maybe_unused]] int thread_id) {
+        VMP_STAT_TIMER_START(construction_timer);
+        vector<int> neighbours;
+        vector<intersection> intersections;
+        for (int i = begin; i < end; i++) {
+            if (!triangulation.is_inserted(i)) {
+                continue;
+            }
+            VoronoiCell vcell(pts[i], i);
+            triangulation.get_voronoi_neighbours(i, neighbours);
+            vcell.construct_cell_from_neighbours(pts, neighbours, intersections);
+            vcells[i] = std::move(vcell);
+        }
+        VMP_STAT_TIMER_STOP(thread_stats[thread_id], cell_construction_time, construction_timer);
+    });
+    for (int t = 0; t < thread_stats.size(); t++) {
+        stats.merge(thread_stats[t]);
+    }
 
-    return new_cell_index;
+    // a seed placed twice is not part of the triangulation
+    vector<int> duplicate_seeds;
+    for (int i = 0; i < pts.size(); i++) {
+        if (!triangulation.is_inserted(i)) {
+            duplicate_seeds.push_back(i);
+        }
+    }
+    construct_duplicate_cells(duplicate_seeds);
 }
 
-// function to determine the smallest positive intersection
-void VoronoiMesh::find_smallest_pos_intersect(Halfplane &current_hp, int &current_cell_index, VoronoiCell &new_cell, Point &last_vertex, int &last_cell_index, Point &vertex, Halfplane &edge_hp) {
-    
-    // calculate distance from last_vertex to the midpoint of the current_cell
-    double last_vertex_dist_to_midpoint = (last_vertex.x - current_hp.midpoint.x)*current_hp.hp_vec.x
-                                        + (last_vertex.y - current_hp.midpoint.y)*current_hp.hp_vec.y;
-
-    // get intersections of current halfplane with all edges of the current cell
-    vector<intersection> intersections;
-    for (int i = 0; i<vcells[current_cell_index].edges.size(); i++) {
-        new_cell.intersect_two_halfplanes(current_hp, vcells[current_cell_index].edges[i], intersections);
+// construct all cells with Fortune's sweepline algorithm: the sweep (serial) finds the neighbours of every cell, then
+// the cells are constructed from their neighbours and the boundaries with the halfplane intersection on n_threads
+// threads. independent of the order of pts
+void VoronoiMesh::construct_mesh_sweepline(int n_threads) {
+
+    FortuneSweep sweep(pts, &stats);
+
+    vcells.clear();
+    vcells.resize(pts.size());
+
+    ThreadPool pool(n_threads);
+    vector<MeshStats> thread_stats(pool.nr_threads);
+    pool.parallel_for(pts.size(), 0, [&](int begin, int end, int thread_id) {
+        VMP_STAT_TIMER_START(construction_timer);
+        vector<int> indices;
+        vector<Point> candidate_pts;
+        for (int i = begin; i < end; i++) {
+            indices.assign(sweep.neighbours.begin() + sweep.neighbour_offsets[i], sweep.neighbours.begin() + sweep.neighbour_offsets[i + 1]);
+            candidate_pts.clear();
+            for (int j = 0; j < indices.size(); j++) {
+                candidate_pts.push_back(pts[indices[j]]);
+            }
+            VoronoiCell vcell(pts[i], i);
+            vcell.construct_cell(candidate_pts, indices, &thread_stats[thread_id]);
+            vcells[i] = std::move(vcell);
+        }
+        VMP_STAT_TIMER_STOP(thread_stats[thread_id], cell_construction_time, construction_timer);
+    });
+    for (int t = 0; t < thread_stats.size(); t++) {
+        stats.merge(thread_stats[t]);
     }
 
-    double dist = 42;
-    double epsilon = 0.000000000000001;
-    bool need_to_check_for_degeneracy = false;
+    construct_duplicate_cells(sweep.duplicate_seeds);
+}
 
-    // find the intersection with smallest but positive relative distance
-    for (int i = 0; i<intersections.size(); i++) {
+// construct every cell on its own by clipping the unit square with the bisectors to its k nearest seeds, closest first.
+// once the next seed is further away than twice the farthest vertex (security radius) the cell is final, otherwise
+// k is doubled. the cells only read pts and the grid, so they are built on n_threads threads without any locking
+void VoronoiMesh::construct_mesh_knn(int n_threads) {
+
+    SeedGrid grid(pts, 3);
+
+    vcells.clear();
+    vcells.resize(pts.size());
+
+    ThreadPool pool(n_threads);
+    vector<MeshStats> thread_stats(pool.nr_threads);
+    vector<vector<int>> thread_duplicates(pool.nr_threads);
+    pool.parallel_for(pts.size(), 0, [&](int begin, int end, int thread_id) {
+        VMP_STAT_TIMER_START(construction_timer);
+        vector<nearest_seed> nearest;
+        ClipPolygon polygon;
+        for (int i = begin; i < end; i++) {
+
+            polygon.reset(pts[i], i);
+            int k = 24;
+            int nr_clipped = 0;
+            bool closed = false;
+            bool fallback = false;
+            bool duplicate = false;
+
+            while (!closed && !fallback && !duplicate) {
+
+                grid.get_nearest(pts, pts[i], k + 1, nearest);
+                double security_radius_squared = polygon.get_security_radius_squared();
+
+                for (int j = nr_clipped; j < nearest.size(); j++) {
+                    int other = nearest[j].index;
+                    if (other == i) {
+                        continue;
+                    }
 
-        // calculate relative distance between intersection and last vertex
-        double rel_dist = intersections[i].dist_to_midpoint - last_vertex_dist_to_midpoint;
+                    // the margin covers the rounding of the verticies, a seed right at the security radius may
+                    // still add an edge of length zero
+                    if (nearest[j].dist_squared > 4 * security_radius_squared * (1 + 1e-9)) {
+                        closed = true;
+                        break;
+                    }
 
-        // reduce dist if rel_dist is smaller
-        if (rel_dist > 0 && rel_dist < dist && !(last_cell_index == (*intersections[i].intersecting_with).index2)) {
+                    // of seeds placed twice only the first one gets a cell here, the others are built at the end
+                    if (nearest[j].dist_squared == 0) {
+                        duplicate = other < i;
+                        if (duplicate) {
+                            break;
+                        }
+                        continue;
+                    }
 
-            if (rel_dist < dist + epsilon && rel_dist > dist - epsilon) {
-                need_to_check_for_degeneracy = true;
+                    if (!polygon.clip(pts[other], other)) {
+                        fallback = true;
+                        break;
+                    }
+                    security_radius_squared = polygon.get_security_radius_squared();
+                }
+                if (nearest.size() < k + 1) {
+                    closed = true;
+                }
+                nr_clipped = nearest.size();
+                k *= 2;
+                if (!closed) {
+                    VMP_STAT_ADD(thread_stats[thread_id], knn_growths, 1);
+                }
             }
 
-            dist = rel_dist;
-            vertex = intersections[i].intersect_pt;
-            edge_hp = *intersections[i].intersecting_with;
-
+            VoronoiCell vcell(pts[i], i);
+            if (duplicate) {
+                thread_duplicates[thread_id].push_back(i);
+            } else if (fallback) {
+                vcell.construct_cell_local(pts, grid, &thread_stats[thread_id]);
+                VMP_STAT_ADD(thread_stats[thread_id], construct_cell_fallbacks, 1);
+            } else {
+                polygon.copy_to_cell(vcell);
+            }
+            vcells[i] = std::move(vcell);
         }
-
+        VMP_STAT_TIMER_STOP(thread_stats[thread_id], cell_construction_time, construction_timer);
+    });
+    for (int t = 0; t < thread_stats.size(); t++) {
+        stats.merge(thread_stats[t]);
     }
 
-    // if degenerate case possible do further checks
-    if (need_to_check_for_degeneracy) {
-        vector<Halfplane> deg_hp_list;
-
-        // recalculate the distances and store the ones same to dist (the minimal distance with tolearnce)
-        for (int i = 0; i < intersections.size(); i++) {
-            double rel_dist = intersections[i].dist_to_midpoint - last_vertex_dist_to_midpoint;
+    vector<int> duplicate_seeds;
+    for (int t = 0; t < thread_duplicates.size(); t++) {
+        duplicate_seeds.insert(duplicate_seeds.end(), thread_duplicates[t].begin(), thread_duplicates[t].end());
+    }
+    sort(duplicate_seeds.begin(), duplicate_seeds.end());
+    construct_duplicate_cells(duplicate_seeds);
+}
 
-            if (rel_dist < dist + epsilon && rel_dist > dist - epsilon) {
-                deg_hp_list.push_back(*intersections[i].intersecting_with);
+// a seed placed twice has no neighbours of its own in the triangulation, the sweep or the clipping -> its cell is
+// generated from all seeds
+void VoronoiMesh::construct_duplicate_cells(const vector<int> &duplicate_seeds) {
+
+    vector<int> pts_indices;
+    for (int k = 0; k < duplicate_seeds.size(); k++) {
+        int i = duplicate_seeds[k];
+        cout << "Seed " << i << " lies on top of another seed. try construct_cell" << endl;
+        if (pts_indices.empty()) {
+            for (int j = 0; j < pts.size(); j++) {
+                pts_indices.push_back(j);
             }
         }
+        vcells[i] = VoronoiCell(pts[i], i);
+        vcells[i].construct_cell(pts, pts_indices, &stats);
+        VMP_STAT_ADD(stats, construct_cell_fallbacks, 1);
+    }
+}
 
-        // out of the degenerate halfplanes find the one with maximum signed angle
-        double max_angle = 0;
-        for (int i = 0; i < deg_hp_list.size(); i++) {
+// find cell in which the point is in: walk to the neighbour closest to the point until no neighbour is closer
+int VoronoiMesh::find_cell_index(Point point) {
+    
+    // start at a cell near by from the hint grid, or at the last generated cell if there is no grid
+    int current_cell_index = hint_grid.empty() ? vcells.back().index : hint_grid.get_hint(point);
+    bool found_cell = true;
+    int steps = 0;
 
-            // calculate signed angle
-            double angle = new_cell.get_signed_angle(current_hp.hp_vec, deg_hp_list[i].hp_vec);
+    // search for cell
+    do {
 
-            if (angle > max_angle) {
-                max_angle = angle;
-                edge_hp = deg_hp_list[i];
-            }
+        const VoronoiCell &current_cell = vcells[current_cell_index];
 
+        // current distance (squared distances order the same way)
+        double new_cell_dist = (point.x - current_cell.seed.x)*(point.x - current_cell.seed.x) + (point.y - current_cell.seed.y)*(point.y - current_cell.seed.y);
+        int new_cell_index = current_cell_index;
+        found_cell = true;
+
+        // try to reduce distance step
+        for (int i = 0; i<current_cell.edges.size(); i++) {
+
+            int index = current_cell.edges[i].index2;
+
+            if (index >= 0) {
+                double dist = (point.x - pts[index].x)*(point.x - pts[index].x) + (point.y - pts[index].y)*(point.y - pts[index].y);
+                if (dist < new_cell_dist) {
+                    new_cell_dist = dist;
+                    new_cell_index = index;
+                    found_cell = false;
+                }
+            }
         }
 
-    }
+        current_cell_index = new_cell_index;
 
+        steps += 1;
+    } while (!found_cell);
 
+    VMP_STAT_ADD(stats, walk_steps, steps);
+    VMP_STAT_MAX(stats, max_walk_steps, steps);
+    total_steps += steps;
+    if (steps > max_steps) {
+        max_steps = steps;
+    }
 
-    
+    return current_cell_index;
 }
 
 // function to determine the index of an edge in the edge list of its voronoi cell
-int VoronoiMesh::get_edge_index_in_cell(int &edge_index, VoronoiCell &vcell) {
+int VoronoiMesh::get_edge_index_in_cell(int edge_index, const VoronoiCell &vcell) {
     
-    int index = -42;
-
-    // loop through edges to find index
+    // loop through edges to find index, a neighbour appears only once
     for (int i = 0; i < vcell.edges.size(); i++) {
         if (edge_index == vcell.edges[i].index2) {
-            index = i;
+            return i;
         }
     }
-    if (index == -42) {
-        cout << "failed to find edge in vcell.edge list" << endl;
-    }
 
-    return index;
-}
-
-// function to do the test if this is the cell where we can leave the boundary again
-bool VoronoiMesh::intersection_between_start_stop(int index, Point &new_seed, int &new_seed_index, int &next_cell_index, VoronoiCell &new_cell) {
-    // condition here will be: if the test_hp has its boundary intersection between the intersections
-    // of the start_hp with boundary and the end_hp with boundary return true. otherwise return false
-
-
-    // here the start, stop intersection and the hp with boundary intersection will be stored
-    vector<intersection> intersections;
-    
-    // for clarity name all the halfplanes
-    Halfplane start_hp = vcells[next_cell_index].edges[(index)%vcells[next_cell_index].edges.size()];
-    Halfplane boundary_hp = vcells[next_cell_index].edges[(index+1)%vcells[next_cell_index].edges.size()];
-    Halfplane end_hp = vcells[next_cell_index].edges[(index+2)%vcells[next_cell_index].edges.size()];
-    Halfplane test_hp = Halfplane(new_seed, vcells[next_cell_index].seed, new_seed_index, next_cell_index);
-
-    // get the intersections
-    new_cell.intersect_two_halfplanes(boundary_hp, start_hp, intersections);
-    new_cell.intersect_two_halfplanes(boundary_hp, end_hp, intersections);
-    new_cell.intersect_two_halfplanes(boundary_hp, test_hp, intersections);
-
-    // again for clarity name the intersections
-    double start = intersections[0].dist_to_midpoint;
-    double end = intersections[1].dist_to_midpoint;
-    double test = intersections[2].dist_to_midpoint;
-
-    // return true if test is in between (<= should handle degeneracys here i think)
-    if (test > start && test <= end) {
-        return true;
-    }
-    
-    return false;
+    cout << "failed to find edge in vcell.edge list" << endl;
+    return -42;
 }
 
 // function to insert a cell into an existing mesh, first generates new_cell and then clips all the cells around as needed
 void VoronoiMesh::insert_cell(Point new_seed, int new_seed_index) {
 
     // find cell the new seed is in
+    VMP_STAT_TIMER_START(location_timer);
     int cell_im_in_index = find_cell_index(new_seed);
-    int current_cell_index = cell_im_in_index;
-    
-    // generate new_cell and initial halfplane
-    VoronoiCell new_cell(new_seed, new_seed_index);
-    Halfplane current_hp(new_seed, vcells[cell_im_in_index].seed, new_seed_index, cell_im_in_index);
-    Halfplane first_hp = current_hp;
+    VMP_STAT_TIMER_STOP(stats, point_location_time, location_timer);
+
+    VMP_STAT_TIMER_START(tracing_timer);
+#ifdef VMP_ENABLE_STATS
+    long long exact_predicates_before = get_exact_predicate_count();
+#endif
+    trace_new_cell(new_seed, new_seed_index, cell_im_in_index);
+    VMP_STAT_ADD(stats, exact_predicates, get_exact_predicate_count() - exact_predicates_before);
+    VMP_STAT_TIMER_STOP(stats, cell_tracing_time, tracing_timer);
+
+    VMP_STAT_TIMER_START(clipping_timer);
+    add_traced_cell();
+    VMP_STAT_TIMER_STOP(stats, neighbour_clipping_time, clipping_timer);
+    VMP_STAT_ADD(stats, inserts, 1);
+}
 
-    // set initial last_vertex
-    Point last_vertex = current_hp.midpoint;
-    int last_cell_index = -42;
+// walk around the new seed starting in the cell it lies in and collect the edges and verticies of its cell in trace_cell.
+// every decision of the walk is a conflict test of a vertex with the new seed (exact predicates, see RobustPredicates.h),
+// the halfplane intersections only compute the coordinates of the new verticies
+void VoronoiMesh::trace_new_cell(Point new_seed, int new_seed_index, int cell_im_in_index) {
+
+    // trace new_cell in a scratch cell that keeps its capacity from insert to insert (a new cell often has more
+    // edges than it ends up with, growing its own arrays here would leave most cells with far too much capacity)
+    VoronoiCell &new_cell = trace_cell;
+    new_cell.seed = new_seed;
+    new_cell.index = new_seed_index;
+    new_cell.edges.clear();
+    new_cell.verticies.clear();
+
+    // the new seed has the highest index so far, cocircular verticies are therefore never in conflict with it
+    PredicateSite new_site = make_site(new_seed, new_seed_index);
+
+    // the cell the seed is in always has verticies in conflict. if the point location was off by a rounding error
+    // one of its neighbours is taken instead
+    int first_cell_index = cell_im_in_index;
+    int exit_edge = guess_exit_edge(vcells[cell_im_in_index], new_seed, new_seed_index, new_site);
+    if (exit_edge < 0) {
+        exit_edge = find_exit_edge(vcells[cell_im_in_index], -1, new_site);
+    }
+    for (int i = 0; exit_edge < 0 && i < vcells[cell_im_in_index].edges.size(); i++) {
+        int index = vcells[cell_im_in_index].edges[i].index2;
+        if (index >= 0) {
+            first_cell_index = index;
+            exit_edge = find_exit_edge(vcells[index], -1, new_site);
+        }
+    }
+    if (exit_edge < 0) {
+        construct_new_cell_fallback(new_seed, new_seed_index);
+        return;
+    }
 
-    // start going around
+    // go around clockwise: in every cell the new edge runs from the edge to the last cell to the exit edge
+    int current_cell_index = first_cell_index;
     int counter = 0;
-    do {
+    while (true) {
 
-    Point vertex;
-    Halfplane edge_hp;
+        const VoronoiCell &current_cell = vcells[current_cell_index];
+        Halfplane current_hp(new_seed, current_cell.seed, new_seed_index, current_cell_index);
+        const Halfplane &edge_hp = current_cell.edges[exit_edge];
 
-    find_smallest_pos_intersect(current_hp,current_cell_index, new_cell, last_vertex,last_cell_index, vertex, edge_hp);
+        // store the edge and the vertex where it leaves the current cell
+        new_cell.edges.push_back(current_hp);
+        new_cell.verticies.push_back(get_intersection_point(current_hp, edge_hp));
 
-    // store the found edge and vertex in cell
-    new_cell.edges.push_back(current_hp);
-    new_cell.verticies.push_back(vertex);
+        int next_cell_index;
+        int arrival_edge;
 
-    // if the algorithm hits an edge
-    if (edge_hp.boundary) {
+        if (!edge_hp.boundary) {
 
-        // push back new edge and get its index
-        new_cell.edges.push_back(edge_hp);
-        int index = get_edge_index_in_cell(edge_hp.index2, vcells[current_cell_index]);
+            next_cell_index = edge_hp.index2;
+            arrival_edge = get_edge_index_in_cell(current_cell_index, vcells[next_cell_index]);
 
-        // go around edge until its time to leave again
-        int counter2 = 0;
-        bool break_condition = false;
-        do {
+        // if the new cell hits the boundary follow it (around corners and through the cells along it) up to
+        // the boundary edge whose end is not in conflict any more, the new cell leaves the boundary there
+        } else {
 
-            // if edge[index+1] is a boundary
-            if (vcells[current_cell_index].edges[(index+1)%vcells[current_cell_index].edges.size()].boundary) {
+            new_cell.edges.push_back(edge_hp);
+            int cell_index = current_cell_index;
+            int index = exit_edge;
+            int counter2 = 0;
 
-                // push back edge[index + 1]
-                new_cell.edges.push_back(vcells[current_cell_index].edges[(index+1)%vcells[current_cell_index].edges.size()]);
+            while (vertex_in_conflict(vcells[cell_index], index, new_site) && counter2 < 1000) {
 
-                // intersect the two boundary edges to get vertex
-                vector<intersection> intersections;
-                new_cell.intersect_two_halfplanes(vcells[current_cell_index].edges[index%vcells[current_cell_index].edges.size()], 
-                                                    vcells[current_cell_index].edges[(index+1)%vcells[current_cell_index].edges.size()],
-                                                    intersections);
-                Point new_vertex = intersections[0].intersect_pt;
+                const VoronoiCell &cell = vcells[cell_index];
+                const Halfplane &following_hp = cell.edges[(index+1)%cell.edges.size()];
 
-                // push back vertex
-                new_cell.verticies.push_back(new_vertex);
+                // corner: the next boundary edge belongs to the new cell as well
+                if (following_hp.boundary) {
+                    new_cell.edges.push_back(following_hp);
+                    new_cell.verticies.push_back(get_intersection_point(cell.edges[index], following_hp));
+                    index = (index+1)%cell.edges.size();
 
+                // go into the next cell along the boundary, its boundary edge follows the edge to this cell
+                } else {
+                    int next_index = following_hp.index2;
+                    index = (get_edge_index_in_cell(cell_index, vcells[next_index]) + 1)%vcells[next_index].edges.size();
+                    cell_index = next_index;
+                    if (!vcells[cell_index].edges[index].boundary) {
+                        counter2 = 1000;
+                    }
+                }
 
-            // if edge[index + 1] is not a boundary
-            } else {
-                
-                // go into next cell
-                int next_cell_index = vcells[current_cell_index].edges[(index+1)%vcells[current_cell_index].edges.size()].index2;
-                index = get_edge_index_in_cell(current_cell_index, vcells[next_cell_index]);
-                current_cell_index = next_cell_index;
-
+                counter2 += 1;
+                VMP_STAT_ADD(stats, boundary_walk_iterations, 1);
+            }
+            if (counter2 >= 1000) {
+                construct_new_cell_fallback(new_seed, new_seed_index);
+                return;
             }
 
-            // find out wether its time to leave
-            break_condition = intersection_between_start_stop(index, new_seed, new_seed_index, current_cell_index, new_cell);
+            // leave the boundary into the cell the walk ended in
+            Halfplane new_hp(new_seed, vcells[cell_index].seed, new_seed_index, cell_index);
+            new_cell.verticies.push_back(get_intersection_point(vcells[cell_index].edges[index], new_hp));
+            next_cell_index = cell_index;
+            arrival_edge = index;
+        }
 
-            if (break_condition) {
-                // time to leave the boundary and continue in normal fashion
+        // the new cell is closed when it is back at the first cell
+        if (next_cell_index == first_cell_index) {
+            break;
+        }
 
-                // get vertex to restart
-                vector<intersection> intersections;
-                Halfplane new_hp(new_seed, vcells[current_cell_index].seed, new_seed_index, current_cell_index);
-                new_cell.intersect_two_halfplanes(vcells[current_cell_index].edges[(index+1)%vcells[current_cell_index].edges.size()], new_hp, intersections);
-                Point restart_vertex = intersections[0].intersect_pt;
-                last_vertex = restart_vertex;
-                new_cell.verticies.push_back(restart_vertex);
+        // the vertex before the arrival edge is in conflict, the exit edge is found by going backwards from it
+        const VoronoiCell &next_cell = vcells[next_cell_index];
+        int n = next_cell.edges.size();
+        exit_edge = (arrival_edge < 0) ? -1 : find_exit_edge(next_cell, (arrival_edge + n - 1)%n, new_site);
+        counter += 1;
+        if (exit_edge < 0 || counter >= 10000) {
+            construct_new_cell_fallback(new_seed, new_seed_index);
+            return;
+        }
+        current_cell_index = next_cell_index;
+    }
 
-                // update other variables to get ready to leave
-                last_cell_index = vcells[current_cell_index].edges[(index+1)%vcells[current_cell_index].edges.size()].index2;
-                current_hp = new_hp;
+}
 
-                counter +=1;
+// the site on the other side of edge i of a cell: the neighbour, or the mirror image of the seed at a boundary
+PredicateSite VoronoiMesh::get_edge_site(const VoronoiCell &vcell, int i) {
 
-            } else {
+    const Halfplane &edge = vcell.edges[i];
+    PredicateSite site;
+    site.pt = edge.boundary ? vcell.seed : pts[edge.index2];
+    site.mirror = edge.boundary ? edge.index2 : 0;
+    site.rank = edge.index2;
+    return site;
+}
 
-                // if breack condition is not fulfilled just increase index by one
-                index += 1;
-                counter2 +=1;
+// is vertex i of the cell (between edges i and i+1) closer to the new seed than to the seeds it belongs to?
+// the cells are clockwise, so the seed and the sites of the two edges are a clockwise triangle
+bool VoronoiMesh::vertex_in_conflict(const VoronoiCell &vcell, int i, const PredicateSite &new_site) {
 
-            }
+    int n = vcell.edges.size();
+    PredicateSite cell_site;
+    cell_site.pt = vcell.seed;
+    cell_site.mirror = 0;
+    cell_site.rank = vcell.index;
+    return incircle_sign_perturbed(cell_site, get_edge_site(vcell, i), get_edge_site(vcell, (i+1)%n), new_site) < 0;
+}
 
-        } while (!(break_condition) && counter2 < 1000);
+// the edge through which the new cell leaves the cell (going clockwise): vertex i-1 is not in conflict, vertex i is.
+// the search goes backwards from vertex start, which should be in conflict. if it is not or start is -1 all verticies
+// are tested. -1 if there is no such edge
+int VoronoiMesh::find_exit_edge(const VoronoiCell &vcell, int start, const PredicateSite &new_site) {
 
-    } else {
+    int n = vcell.edges.size();
 
-        // some updates of variables before redoing all steps
-        last_vertex = vertex;
-        last_cell_index = current_cell_index;
-        current_cell_index = edge_hp.index2;
-        current_hp = Halfplane(new_seed, vcells[current_cell_index].seed, new_seed_index, current_cell_index);
-    
-        // counting to break do_while when in infinite loop
-        counter += 1;
-        if (counter >= 10000) {
-
-                    // if counter exeeds limit just generate the cell with the half plane intersection algoithm -> way slower in that case but more robust.
-                    cout << "Failed to generate cell using pt_insertion. At: " << pts.size() <<  ". try construct_cell" << endl;
-                    VoronoiCell alternative_cell(new_seed, new_seed_index);
-                    vector<int> pts_indices;
-                    for (int i = 0; i<pts.size(); i++) {
-                        pts_indices.push_back(i);
-                    }
-                    alternative_cell.construct_cell(pts, pts_indices);
-                    new_cell = alternative_cell;
-                    cout << "cell generated using slow construct_cell algorithm. continue on other pts with point insertion" << endl;
-                }
+    if (start >= 0 && vertex_in_conflict(vcell, start, new_site)) {
+        int i = start;
+        for (int k = 1; k < n; k++) {
+            int previous = (i + n - 1)%n;
+            if (!vertex_in_conflict(vcell, previous, new_site)) {
+                return i;
+            }
+            i = previous;
+        }
+        return -1;
     }
 
-    } while (!(first_hp.index2 == current_hp.index2) && counter < 10000);
+    // scan forwards and stop at the first vertex in conflict after one that is not, the conflict of the last
+    // vertex is only needed if the first vertex is in conflict
+    bool first_in_conflict = vertex_in_conflict(vcell, 0, new_site);
+    bool previous_in_conflict = first_in_conflict;
+    for (int i = 1; i < n; i++) {
+        bool current_in_conflict = vertex_in_conflict(vcell, i, new_site);
+        if (current_in_conflict && !previous_in_conflict) {
+            return i;
+        }
+        previous_in_conflict = current_in_conflict;
+    }
+    if (first_in_conflict && !previous_in_conflict) {
+        return 0;
+    }
+    return -1;
+}
 
-    // vector memory management
-    new_cell.halfplanes.shrink_to_fit();
-    new_cell.edges.shrink_to_fit();
-    new_cell.verticies.shrink_to_fit();
+// the first exit edge without testing every vertex: the bisector of the new seed and the seed of the cell it lies in
+// leaves the cell (clockwise) through the edge with the smallest positive intersection from its midpoint, which lies
+// inside the cell. the kernel of the halfplane intersection finds it in one pass, the exact predicates confirm it
+// (vertex i in conflict, i-1 not). -1 if they do not, then all verticies have to be tested
+int VoronoiMesh::guess_exit_edge(const VoronoiCell &vcell, Point new_seed, int new_seed_index, const PredicateSite &new_site) {
+
+    int n = vcell.edges.size();
+    Halfplane current_hp(new_seed, vcell.seed, new_seed_index, vcell.index);
+    edge_batch.assign(vcell.edges.data(), n);
+    batch_intersection closest = edge_batch.find_smallest_pos_intersect(current_hp, 0, 0, 42, -42, -42);
+    VMP_STAT_ADD(stats, halfplane_intersections, n);
+
+    int i = closest.index;
+    if (i >= 0 && vertex_in_conflict(vcell, i, new_site) && !vertex_in_conflict(vcell, (i + n - 1)%n, new_site)) {
+        return i;
+    }
+    return -1;
+}
+
+// intersection point of two edges (same arithmetic as intersect_two_halfplanes)
+Point VoronoiMesh::get_intersection_point(Halfplane hp1, Halfplane hp2) {
+
+    vector<intersection> &intersections = intersection_buffer;
+    intersections.clear();
+    trace_cell.intersect_two_halfplanes(hp1, hp2, intersections);
+    VMP_STAT_ADD(stats, halfplane_intersections, 1);
+    if (intersections.empty()) {
+        return hp1.midpoint;
+    }
+    return intersections[0].intersect_pt;
+}
 
-    // store new_cell in vcells and new point in pts
-    vcells.push_back(new_cell);
-    pts.push_back(new_seed);
+// if the mesh around the new seed does not allow to trace its cell (only a seed placed twice), the cell is generated
+// with the halfplane intersection algorithm from all seeds -> way slower but independent of the neighbours
+void VoronoiMesh::construct_new_cell_fallback(Point new_seed, int new_seed_index) {
 
+    cout << "Failed to generate cell using pt_insertion. At: " << pts.size() <<  ". try construct_cell" << endl;
+    VoronoiCell alternative_cell(new_seed, new_seed_index);
+    vector<int> pts_indices;
+    for (int i = 0; i<pts.size(); i++) {
+        pts_indices.push_back(i);
+    }
+    alternative_cell.construct_cell(pts, pts_indices, &stats);
+    VMP_STAT_ADD(stats, construct_cell_fallbacks, 1);
+    trace_cell = alternative_cell;
+    cout << "cell generated using slow construct_cell algorithm. continue on other pts with point insertion" << endl;
+}
 
-    // clipping all the neighbour cells
+// store the traced cell as the next cell of the mesh and clip all its neighbours
+void VoronoiMesh::add_traced_cell() {
+
+    const VoronoiCell &new_cell = trace_cell;
+
+    // store new_cell in vcells with two spare slots for the clipping of later inserts and new point in pts
+    VoronoiCell stored_cell;
+    stored_cell.seed = new_cell.seed;
+    stored_cell.index = new_cell.index;
+    stored_cell.edges.reserve(new_cell.edges.size() + 2);
+    stored_cell.edges.assign(new_cell.edges.begin(), new_cell.edges.end());
+    stored_cell.verticies.reserve(new_cell.verticies.size() + 2);
+    stored_cell.verticies.assign(new_cell.verticies.begin(), new_cell.verticies.end());
+    vcells.push_back(std::move(stored_cell));
+    pts.push_back(new_cell.seed);
+    const VoronoiCell &inserted_cell = vcells.back();
+    int nr_edges = inserted_cell.edges.size();
+
+    // clipping all the neighbour cells in place
     // loop through all edges of new cell
-    for (int i = 0; i<new_cell.edges.size(); i++) {
+    for (int i = 0; i<nr_edges; i++) {
  
-        Halfplane edge = new_cell.edges[i];
+        const Halfplane &edge = inserted_cell.edges[i];
 
         // start and end named in perspective of cell to adapt
-        Point v_end = new_cell.verticies[(i-1 + new_cell.verticies.size())%new_cell.verticies.size()];
-        Point v_start = new_cell.verticies[i];
+        Point v_end = inserted_cell.verticies[(i-1 + nr_edges)%nr_edges];
+        Point v_start = inserted_cell.verticies[i];
 
         // only adapt cell if not boundary
         if (edge.index2 >= 0) {
 
+            VMP_STAT_ADD(stats, clip_splices, 1);
+
             // get cell to adapt, start index and end index and edge to insert
-            VoronoiCell cell_to_adapt = vcells[edge.index2];
-            int edge_start_index = get_edge_index_in_cell(new_cell.edges[(i+1)%new_cell.edges.size()].index2, cell_to_adapt);
-            int edge_end_index = get_edge_index_in_cell(new_cell.edges[(i-1 + new_cell.edges.size())%new_cell.edges.size()].index2, cell_to_adapt);
+            VoronoiCell &cell_to_adapt = vcells[edge.index2];
+            EdgeList &edges = cell_to_adapt.edges;
+            VertexList &verticies = cell_to_adapt.verticies;
+            int edge_start_index = get_edge_index_in_cell(inserted_cell.edges[(i+1)%nr_edges].index2, cell_to_adapt);
+            int edge_end_index = get_edge_index_in_cell(inserted_cell.edges[(i-1 + nr_edges)%nr_edges].index2, cell_to_adapt);
             Halfplane edge_to_insert(pts[edge.index2], pts[edge.index1], edge.index2, edge.index1);
+            int inserted_index;
 
-            // simple case if the end of the vector is not crossed
+            // simple case if the end of the vector is not crossed:
+            // edges[start+1..end) are replaced by the new edge, verticies[start..end) by v_start and v_end
             if (edge_start_index < edge_end_index) {
 
-                // adapt edges
-                cell_to_adapt.edges.erase(cell_to_adapt.edges.begin() + edge_start_index + 1, cell_to_adapt.edges.begin() + edge_end_index);
-                cell_to_adapt.edges.insert(cell_to_adapt.edges.begin() + edge_start_index + 1, edge_to_insert);
+                int s = edge_start_index;
+                int e = edge_end_index;
+
+                // adapt edges (overwrite the first clipped edge, close the gap of the others)
+                if (e - s > 1) {
+                    edges[s + 1] = edge_to_insert;
+                    edges.erase(edges.begin() + s + 2, edges.begin() + e);
+                } else {
+                    // the cell gains an edge: grow by a little instead of doubling the capacity
+                    if (edges.size() == edges.capacity()) {
+                        edges.reserve(edges.size() + 2);
+                        verticies.reserve(edges.size() + 2);
+                    }
+                    edges.insert(edges.begin() + s + 1, edge_to_insert);
+                }
 
                 // adapt verticies
-                cell_to_adapt.verticies.erase(cell_to_adapt.verticies.begin() + edge_start_index, cell_to_adapt.verticies.begin() + edge_end_index);
-                cell_to_adapt.verticies.insert(cell_to_adapt.verticies.begin() + edge_start_index, v_start);
-                cell_to_adapt.verticies.insert(cell_to_adapt.verticies.begin() + edge_start_index + 1, v_end);
+                verticies[s] = v_start;
+                if (e - s > 1) {
+                    verticies[s + 1] = v_end;
+                    verticies.erase(verticies.begin() + s + 2, verticies.begin() + e);
+                } else {
+                    verticies.insert(verticies.begin() + s + 1, v_end);
+                }
+                inserted_index = s + 1;
 
-            // more complex case if the end of the vector is crossed during clipping. conceptually doing exactly the same but kind of an index mess
-            } else if (edge_start_index > edge_end_index) {
+            // the clipped range crosses the end of the vector and index 0 is kept: cut the tail and append
+            } else if (edge_start_index > edge_end_index && edge_end_index == 0) {
 
-                // erase edges
-                if (edge_start_index < cell_to_adapt.edges.size()-1) {
-                    cell_to_adapt.edges.erase(cell_to_adapt.edges.begin() + edge_start_index + 1, cell_to_adapt.edges.end());
+                int s = edge_start_index;
+
+                if (s + 2 > edges.capacity()) {
+                    edges.reserve(s + 3);
+                    verticies.reserve(s + 3);
                 }
-                cell_to_adapt.edges.erase(cell_to_adapt.edges.begin(), cell_to_adapt.edges.begin() + edge_end_index);
-
-                // erase verticies
-                cell_to_adapt.verticies.erase(cell_to_adapt.verticies.begin() + edge_start_index, cell_to_adapt.verticies.end());
-
-                // adapt verticies and edges
-                if (edge_end_index > 0) {
-                    cell_to_adapt.verticies.erase(cell_to_adapt.verticies.begin(), cell_to_adapt.verticies.begin() + edge_end_index );
-                    cell_to_adapt.verticies.insert(cell_to_adapt.verticies.end(), v_start);
-                    cell_to_adapt.verticies.insert(cell_to_adapt.verticies.begin(), v_end);
-                    cell_to_adapt.edges.insert(cell_to_adapt.edges.begin(), edge_to_insert);
-                // also adapt verticies and edges but nothing to delete now
-                } else {
-                    cell_to_adapt.verticies.insert(cell_to_adapt.verticies.end(), v_start);
-                    cell_to_adapt.verticies.insert(cell_to_adapt.verticies.end(), v_end);
-                    cell_to_adapt.edges.push_back(edge_to_insert);
-                }       
+                edges.resize(s + 1);
+                edges.push_back(edge_to_insert);
+                verticies.resize(s);
+                verticies.push_back(v_start);
+                verticies.push_back(v_end);
+                inserted_index = s + 1;
+
+            // the clipped range crosses the end of the vector: rotate the kept part to the front, the new edge becomes index 0
+            } else if (edge_start_index > edge_end_index) {
+
+                int s = edge_start_index;
+                int e = edge_end_index;
+                int kept = s - e + 1;
+
+                // edges: edges[e..s] then the new edge, rotated by one so that the new edge is first
+                rotate(edges.begin(), edges.begin() + e, edges.end());
+                edges.resize(kept);
+                edges.push_back(edge_to_insert);
+                rotate(edges.begin(), edges.end() - 1, edges.end());
+
+                // verticies: v_end, verticies[e..s-1], v_start
+                rotate(verticies.begin(), verticies.begin() + e, verticies.end());
+                verticies.resize(kept - 1);
+                verticies.push_back(v_start);
+                verticies.push_back(v_end);
+                rotate(verticies.begin(), verticies.end() - 1, verticies.end());
+                inserted_index = 0;
+
             } else {
                 cout << "while adapting cell: start and end index are the same. that shouldnt happen" << endl;
+                continue;
             }
 
             // restore property that index 0 is the one with seed closest to cell_to_adapt.seed
-            // for that calculate distances
-            double new_dist = sqrt((edge_to_insert.midpoint.x-cell_to_adapt.seed.x)*(edge_to_insert.midpoint.x-cell_to_adapt.seed.x)
-                                    + (edge_to_insert.midpoint.y-cell_to_adapt.seed.y)*(edge_to_insert.midpoint.y-cell_to_adapt.seed.y));
+            // for that calculate (squared) distances
+            double new_dist = (edge_to_insert.midpoint.x-cell_to_adapt.seed.x)*(edge_to_insert.midpoint.x-cell_to_adapt.seed.x)
+                            + (edge_to_insert.midpoint.y-cell_to_adapt.seed.y)*(edge_to_insert.midpoint.y-cell_to_adapt.seed.y);
             
-            double old_dist = sqrt((cell_to_adapt.edges[0].midpoint.x-cell_to_adapt.seed.x)*(cell_to_adapt.edges[0].midpoint.x-cell_to_adapt.seed.x)
-                                    + (cell_to_adapt.edges[0].midpoint.y-cell_to_adapt.seed.y)*(cell_to_adapt.edges[0].midpoint.y-cell_to_adapt.seed.y));
+            double old_dist = (edges[0].midpoint.x-cell_to_adapt.seed.x)*(edges[0].midpoint.x-cell_to_adapt.seed.x)
+                            + (edges[0].midpoint.y-cell_to_adapt.seed.y)*(edges[0].midpoint.y-cell_to_adapt.seed.y);
 
-            // resort edge vector if new dist < old dist
+            // rotate the new edge to the front if it is closer
             if (new_dist < old_dist) {
-
-                vector<Halfplane> new_edge_list;
-                vector<Point> new_verticies_list;
-
-                // get index of inserted edge in cell to adapt
-                int index;
-                for (int j = 0; j < cell_to_adapt.edges.size(); j++) {
-                    if (edge_to_insert.index2 == cell_to_adapt.edges[j].index2) {
-                        index = j;
-                    }
-                }
-
-                // resort the vector
-                for (int j = index; j<cell_to_adapt.edges.size()+index; j++) {
-                    new_edge_list.push_back(cell_to_adapt.edges[j%cell_to_adapt.edges.size()]);
-                    new_verticies_list.push_back(cell_to_adapt.verticies[j%cell_to_adapt.verticies.size()]);
-                }
-                cell_to_adapt.edges = new_edge_list;
-                cell_to_adapt.verticies = new_verticies_list;
-
+                rotate(edges.begin(), edges.begin() + inserted_index, edges.end());
+                rotate(verticies.begin(), verticies.begin() + inserted_index, verticies.end());
             }
 
-            // replace vcell with clipped vcell
-            vcells[edge.index2] = cell_to_adapt;
+#ifdef VMP_CELL_POOL
+            // a cell that lost many edges gives the spare capacity back right away, the pool hands the freed
+            // blocks to the next new cells of that size (with plain heap allocations this is done once at the end)
+            if (edges.capacity() > edges.size() + 4) {
+                EdgeList shrunk_edges;
+                shrunk_edges.reserve(edges.size() + 2);
+                shrunk_edges.assign(edges.begin(), edges.end());
+                edges.swap(shrunk_edges);
+                VertexList shrunk_verticies;
+                shrunk_verticies.reserve(verticies.size() + 2);
+                shrunk_verticies.assign(verticies.begin(), verticies.end());
+                verticies.swap(shrunk_verticies);
+            }
+#endif
         
         }
 
@@ -442,41 +805,508 @@ void VoronoiMesh::do_point_insertion() {
     vector<Point> all_pts = pts;
     pts.clear();
 
+    // all cells are stored right away, so vcells never has to move the cells while growing
+    vcells.reserve(all_pts.size());
+    pts.reserve(all_pts.size());
+
     // do the first few points with old algorithm
     for (int i=0; i<3; i++) {
         pts.push_back(all_pts[i]);
     }
     construct_mesh();
 
+    // start cells for the walks in find_cell_index, independent of the insertion order
+    hint_grid = HintGrid(all_pts.size());
+    for (int i = 0; i < pts.size(); i++) {
+        hint_grid.add_point(pts[i], i);
+    }
+
     // do point insertion
     for (int i = 3; i<all_pts.size(); i++) {
-        if (i%100000 == 0) {
+        if (i%100000 == 0 && print_progress) {
             cout << "progress: " << i << "/" << all_pts.size() << "  -> " << static_cast<double>(i)/static_cast<double>(all_pts.size())*100 << " % " << endl;
         }
         insert_cell(all_pts[i], i);
+        hint_grid.add_point(all_pts[i], i);
+    }
+
+    // the grid is only needed while inserting
+    hint_grid = HintGrid();
+
+    // cells are large while their neighbours are not inserted yet and keep that capacity when clipped -> give it back
+    for (int i = 0; i < vcells.size(); i++) {
+        if (vcells[i].edges.capacity() > vcells[i].edges.size() + 2) {
+            vcells[i].edges.shrink_to_fit();
+            vcells[i].verticies.shrink_to_fit();
+        }
     }
 }
 
 
-// save the mesh to files (seedfile, edgefile, vertexfile)
-void VoronoiMesh::save_mesh_to_files(int nr) {
+// perform point insertion in biased randomized insertion order (BRIO, see get_brio_order) instead of the order of pts.
+// the walks of find_cell_index stay short for any input order, so the expected cost is O(nlogn) without a presort.
+// afterwards the cells are stored in the original order again: cell i belongs to pts[i]
+void VoronoiMesh::do_brio_point_insertion() {
 
-    // save seeds to file
-    string name = "files/seed_list" + to_string(nr) + ".csv";
+    int N = pts.size();
+    vector<int> order = get_brio_order(pts);
+
+    vector<Point> original_pts;
+    original_pts.swap(pts);
+    pts.resize(N);
+    for (int k = 0; k < N; k++) {
+        pts[k] = original_pts[order[k]];
+    }
+
+    do_point_insertion();
+
+    // translate the insertion indices back to the original ones
+    vector<VoronoiCell> ordered_cells(N);
+    for (int k = 0; k < N; k++) {
 
-    ofstream seed_list(name);
+        VoronoiCell &cell = vcells[k];
+        cell.index = order[k];
+        for (int e = 0; e < cell.edges.size(); e++) {
+            if (cell.edges[e].index1 >= 0) {
+                cell.edges[e].index1 = order[cell.edges[e].index1];
+            }
+            if (cell.edges[e].index2 >= 0) {
+                cell.edges[e].index2 = order[cell.edges[e].index2];
+            }
+        }
+        ordered_cells[order[k]] = std::move(cell);
+    }
+
+    vcells.swap(ordered_cells);
+    pts.swap(original_pts);
+}
+
+// perform point insertion on tiles of the unit square in parallel and stitch the tiles into one mesh (pts keep their order)
+void VoronoiMesh::do_parallel_point_insertion(int n_threads) {
+
+    int N = pts.size();
+    if (N <= 3) {
+        construct_mesh();
+        return;
+    }
+
+    // tiles of about 10000 seeds, independent of n_threads so that the mesh does not depend on the thread count
+    int tiles_per_dim = static_cast<int>(ceil(sqrt(N / 10000.0)));
+    if (tiles_per_dim < 1) {
+        tiles_per_dim = 1;
+    }
+    int nr_tiles = tiles_per_dim * tiles_per_dim;
+    double tile_width = 1.0 / tiles_per_dim;
+
+    // ghost seeds within the halo make the cells at the tile seams correct
+    double halo_width = TileRegion::get_halo_width(N);
+
+    // tile coordinate of a position, clamped to the tiles
+    auto tile_coord = [&](double x) {
+        int t = static_cast<int>(x * tiles_per_dim);
+        return t < 0 ? 0 : (t >= tiles_per_dim ? tiles_per_dim - 1 : t);
+    };
+
+    // put every seed into its own tile and into the halo of all other tiles it is close to
+    vector<vector<int> > tile_own(nr_tiles);
+    vector<vector<int> > tile_ghosts(nr_tiles);
+    vector<int> owner_tile(N);
+    for (int i = 0; i < N; i++) {
+
+        owner_tile[i] = tile_coord(pts[i].y) * tiles_per_dim + tile_coord(pts[i].x);
+        tile_own[owner_tile[i]].push_back(i);
+
+        for (int ty = tile_coord(pts[i].y - halo_width); ty <= tile_coord(pts[i].y + halo_width); ty++) {
+            for (int tx = tile_coord(pts[i].x - halo_width); tx <= tile_coord(pts[i].x + halo_width); tx++) {
+                if (ty * tiles_per_dim + tx != owner_tile[i]) {
+                    tile_ghosts[ty * tiles_per_dim + tx].push_back(i);
+                }
+            }
+        }
+    }
+
+    vcells.clear();
+    vcells.resize(N);
+    vector<char> pending(N, 1);
+    vector<long> tile_steps(nr_tiles, 0);
+    vector<int> tile_max_steps(nr_tiles, 0);
+    vector<MeshStats> tile_stats(nr_tiles);
+
+    // cells that seeds outside of the halo could still clip are kept back and the tile is meshed again with a wider
+    // halo, until all cells of the tile are final (like the tiles of TiledMesher)
+    ThreadPool pool(n_threads);
+    pool.parallel_for(nr_tiles, 1, [&](int begin, int end, int) {
+        for (int tile = begin; tile < end; tile++) {
+
+            vector<int> &own = tile_own[tile];
+            int tx = tile % tiles_per_dim;
+            int ty = tile / tiles_per_dim;
+            int nr_pending = own.size();
+            double h = halo_width;
+
+            for (int attempt = 0; nr_pending > 0; attempt++) {
+
+                // region of the unit square whose seeds are all known to this tile
+                TileRegion region(tx, ty, tile_width, h);
+
+                // ghost seeds: the halo, for a wider halo the seeds of all tiles around that lie within the region
+                vector<int> members(own);
+                if (attempt == 0) {
+                    members.insert(members.end(), tile_ghosts[tile].begin(), tile_ghosts[tile].end());
+                } else {
+                    for (int oy = tile_coord(region.y_min); oy <= tile_coord(region.y_max); oy++) {
+                        for (int ox = tile_coord(region.x_min); ox <= tile_coord(region.x_max); ox++) {
+                            if (oy * tiles_per_dim + ox == tile) {
+                                continue;
+                            }
+                            vector<int> &other = tile_own[oy * tiles_per_dim + ox];
+                            for (int k = 0; k < other.size(); k++) {
+                                if (region.contains(pts[other[k]])) {
+                                    members.push_back(other[k]);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                // insert the local seeds along a hilbert curve so that the walks stay short
+                vector<uint64_t> keys(members.size());
+                for (int k = 0; k < members.size(); k++) {
+                    keys[k] = get_hilbert_key(pts[members[k]]);
+                }
+                vector<int> order = radix_sort_keys(keys);
+
+                vector<Point> local_pts(members.size());
+                vector<int> local_to_global(members.size());
+                for (int k = 0; k < order.size(); k++) {
+                    local_to_global[k] = members[order[k]];
+                    local_pts[k] = pts[local_to_global[k]];
+                }
+
+                // mesh the tile together with its halo
+                VoronoiMesh local_mesh(local_pts);
+                local_mesh.print_progress = false;
+                if (local_pts.size() > 3) {
+                    local_mesh.do_point_insertion();
+                } else {
+                    local_mesh.construct_mesh();
+                }
+                tile_steps[tile] += local_mesh.total_steps;
+                tile_max_steps[tile] = max(tile_max_steps[tile], local_mesh.max_steps);
+                tile_stats[tile].merge(local_mesh.stats);
+
+                for (int k = 0; k < local_mesh.vcells.size(); k++) {
+
+                    int global_index = local_to_global[k];
+                    if (owner_tile[global_index] != tile || !pending[global_index]) {
+                        continue;
+                    }
+
+                    VoronoiCell &cell = local_mesh.vcells[k];
+                    if (!region.covers(cell)) {
+                        continue;
+                    }
+
+                    // stitch: translate local indices into global ones
+                    cell.index = global_index;
+                    for (int e = 0; e < cell.edges.size(); e++) {
+                        if (cell.edges[e].index1 >= 0) {
+                            cell.edges[e].index1 = local_to_global[cell.edges[e].index1];
+                        }
+                        if (cell.edges[e].index2 >= 0) {
+                            cell.edges[e].index2 = local_to_global[cell.edges[e].index2];
+                        }
+                    }
+                    vcells[global_index] = std::move(cell);
+                    pending[global_index] = 0;
+                    nr_pending--;
+                }
+
+                if (nr_pending > 0) {
+                    h = TileRegion::widen_halo(h, tile_width);
+                    VMP_STAT_ADD(tile_stats[tile], halo_growths, 1);
+                }
+            }
+        }
+    });
+
+    for (int tile = 0; tile < nr_tiles; tile++) {
+        total_steps += tile_steps[tile];
+        if (tile_max_steps[tile] > max_steps) {
+            max_steps = tile_max_steps[tile];
+        }
+        stats.merge(tile_stats[tile]);
+    }
+
+}
+
+// intersection of the lines of two halfplanes (same linear system as VoronoiCell::intersect_two_halfplanes)
+static bool intersect_halfplane_lines(const Halfplane &hp1, const Halfplane &hp2, Point &pt) {
+
+    double D = hp1.hp_vec.x * hp2.hp_vec.y - hp1.hp_vec.y * hp2.hp_vec.x;
+    if (D == 0) {
+        return false;
+    }
+    double Dx = (hp2.midpoint.x - hp1.midpoint.x) * hp2.hp_vec.y - (hp2.midpoint.y - hp1.midpoint.y) * hp2.hp_vec.x;
+    double x = Dx / D;
+
+    pt = Point(hp1.midpoint.x + x * hp1.hp_vec.x, hp1.midpoint.y + x * hp1.hp_vec.y);
+    return true;
+}
+
+// move the seeds to new_pts (same order as pts) and repair only the cells whose neighbourhood changed.
+// all cells keep their edges, the vertices are recomputed from the moved seeds. a cell is rebuilt if its polygon
+// is no longer convex and clockwise or a seed of its second ring (neighbours of neighbours) lies inside the circle
+// around one of its vertices. returns the number of rebuilt cells, -1 if new_pts does not have one seed per cell.
+// this only pays off for small steps: random motion by 1% of the seed spacing rebuilds about 10% of the cells,
+// from about 3% on most of the mesh is constructed again
+int VoronoiMesh::update_mesh(const vector<Point> &new_pts, int n_threads) {
+
+    int N = vcells.size();
+    if (new_pts.size() != N) {
+        cout << "update_mesh: " << new_pts.size() << " seeds for a mesh of " << N << " cells" << endl;
+        return -1;
+    }
+    pts = new_pts;
+
+    ThreadPool pool(n_threads);
+    vector<char> rebuild(N, 0);
+
+    // step 1a: keep the topology, recompute halfplanes and vertices and check the polygon. every thread only
+    // touches its own cells, the neighbours are read in step 1b after all halfplanes are written
+    pool.parallel_for(N, 0, [&](int begin, int end, int) {
+
+        for (int i = begin; i < end; i++) {
+
+            VoronoiCell &cell = vcells[i];
+            int m = cell.edges.size();
+            cell.seed = pts[i];
+
+            for (int j = 0; j < m; j++) {
+                if (!cell.edges[j].boundary) {
+                    int n = cell.edges[j].index2;
+                    cell.edges[j] = Halfplane(cell.seed, pts[n], i, n);
+                }
+            }
+
+            bool keeps_topology = true;
+
+            // vertex j lies between edges j and j+1
+            for (int j = 0; j < m && keeps_topology; j++) {
+                if (!intersect_halfplane_lines(cell.edges[j], cell.edges[(j + 1) % m], cell.verticies[j])) {
+                    keeps_topology = false;
+                }
+            }
+
+            // every edge has to keep a positive length along its direction (cells are clockwise) and stay inside the box
+            for (int j = 0; j < m && keeps_topology; j++) {
+
+                Point &v0 = cell.verticies[(j + m - 1) % m];
+                Point &v1 = cell.verticies[j];
+                double along = (v1.x - v0.x) * cell.edges[j].hp_vec.x + (v1.y - v0.y) * cell.edges[j].hp_vec.y;
+
+                if (!(along > 0) || v1.x < -1e-12 || v1.x > 1 + 1e-12 || v1.y < -1e-12 || v1.y > 1 + 1e-12) {
+                    keeps_topology = false;
+                }
+            }
+
+            if (!keeps_topology) {
+                rebuild[i] = 1;
+            }
+        }
+    });
+
+    // step 1b: empty circle, no seed of the second ring may be closer to a vertex than the own seed (cells are only read)
+    pool.parallel_for(N, 0, [&](int begin, int end, int) {
+
+        vector<int> candidates;
+
+        for (int i = begin; i < end; i++) {
+
+            if (rebuild[i] == 1) {
+                continue;
+            }
+
+            const VoronoiCell &cell = vcells[i];
+            int m = cell.edges.size();
+
+            candidates.clear();
+            for (int j = 0; j < m; j++) {
+                int n = cell.edges[j].index2;
+                if (n < 0) {
+                    continue;
+                }
+                candidates.push_back(n);
+                for (int k = 0; k < vcells[n].edges.size(); k++) {
+                    int nn = vcells[n].edges[k].index2;
+                    if (nn >= 0 && nn != i) {
+                        candidates.push_back(nn);
+                    }
+                }
+            }
+
+            bool keeps_topology = true;
+            for (int j = 0; j < m && keeps_topology; j++) {
+
+                const Point &v = cell.verticies[j];
+                double own_dist = (v.x - cell.seed.x)*(v.x - cell.seed.x) + (v.y - cell.seed.y)*(v.y - cell.seed.y);
+
+                for (int k = 0; k < candidates.size(); k++) {
+                    Point &other = pts[candidates[k]];
+                    double dist = (v.x - other.x)*(v.x - other.x) + (v.y - other.y)*(v.y - other.y);
+                    if (dist < own_dist * (1 - 1e-12)) {
+                        keeps_topology = false;
+                        break;
+                    }
+                }
+            }
+
+            if (!keeps_topology) {
+                rebuild[i] = 1;
+            }
+        }
+    });
+
+    // step 2: collect the invalid cells, their neighbours follow through the reciprocity check below
+    vector<int> to_rebuild;
+    for (int i = 0; i < N; i++) {
+        if (rebuild[i] == 1) {
+            to_rebuild.push_back(i);
+        }
+    }
+    if (to_rebuild.empty()) {
+        return 0;
+    }
+
+    // most of the topology changed (large steps compared to the seed spacing) -> building from scratch is cheaper
+    if (3 * to_rebuild.size() > N) {
+        vcells.clear();
+        if (n_threads > 1) {
+            do_parallel_point_insertion(n_threads);
+        } else {
+            do_point_insertion();
+        }
+        return N;
+    }
+
+    SeedGrid grid(pts, 2);
+    int nr_rebuilt = 0;
+
+    // step 3: rebuild, then make sure every neighbour relation is known on both sides, else rebuild that cell too
+    auto lists_neighbour = [&](int cell_index, int neighbour) {
+        const VoronoiCell &cell = vcells[cell_index];
+        for (int j = 0; j < cell.edges.size(); j++) {
+            if (cell.edges[j].index2 == neighbour) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    while (!to_rebuild.empty()) {
+
+        // old neighbours of the cells that are rebuilt now, they may have lost the edge to them
+        vector<int> old_neighbours;
+        for (int r = 0; r < to_rebuild.size(); r++) {
+            const VoronoiCell &cell = vcells[to_rebuild[r]];
+            for (int j = 0; j < cell.edges.size(); j++) {
+                if (cell.edges[j].index2 >= 0) {
+                    old_neighbours.push_back(cell.edges[j].index2);
+                }
+            }
+        }
+
+        pool.parallel_for(to_rebuild.size(), 0, [&](int begin, int end, int) {
+            for (int r = begin; r < end; r++) {
+                int i = to_rebuild[r];
+                VoronoiCell vcell(pts[i], i);
+                vcell.construct_cell_local(pts, grid);
+                vcell.halfplanes.shrink_to_fit();       // the candidates are not needed any more, the cell stays for many frames
+                vcells[i] = std::move(vcell);
+            }
+        });
+        nr_rebuilt += to_rebuild.size();
+
+        // rebuilt cells are marked with 2 and never need another pass
+        for (int r = 0; r < to_rebuild.size(); r++) {
+            rebuild[to_rebuild[r]] = 2;
+        }
+
+        vector<int> next_rebuild;
+
+        // a new neighbour of a rebuilt cell has to know it
+        for (int r = 0; r < to_rebuild.size(); r++) {
+            const VoronoiCell &cell = vcells[to_rebuild[r]];
+            for (int j = 0; j < cell.edges.size(); j++) {
+                int n = cell.edges[j].index2;
+                if (n >= 0 && rebuild[n] == 0 && !lists_neighbour(n, cell.index)) {
+                    rebuild[n] = 1;
+                    next_rebuild.push_back(n);
+                }
+            }
+        }
+
+        // an untouched old neighbour may only keep edges to rebuilt cells that still know it
+        for (int a = 0; a < old_neighbours.size(); a++) {
+            int n = old_neighbours[a];
+            if (rebuild[n] != 0) {
+                continue;
+            }
+            const VoronoiCell &cell = vcells[n];
+            for (int j = 0; j < cell.edges.size(); j++) {
+                int k = cell.edges[j].index2;
+                if (k >= 0 && rebuild[k] == 2 && !lists_neighbour(k, n)) {
+                    rebuild[n] = 1;
+                    next_rebuild.push_back(n);
+                    break;
+                }
+            }
+        }
+
+        to_rebuild.swap(next_rebuild);
+    }
+
+    return nr_rebuilt;
+}
+
+// write the text of one mesh file, gzip compressed (name + ".gz") if asked for and zlib is available
+void write_mesh_file(const string &name, const string &content, bool compress) {
+
+#ifdef VMP_HAVE_ZLIB
+    if (compress) {
+        gzFile file = gzopen((name + ".gz").c_str(), "wb1");
+        if (file == nullptr) {
+            cout << "could not open " << name << ".gz for writing" << endl;
+            return;
+        }
+        gzwrite(file, content.data(), content.size());
+        gzclose(file);
+        return;
+    }
+#endif
+
+    ofstream file(name);
+    file << content;
+    file.close();
+}
+
+// save the mesh to files (seedfile, edgefile, vertexfile), optionally gzip compressed
+void VoronoiMesh::save_mesh_to_files(int nr, bool compress) {
+
+    VMP_STAT_TIMER_START(output_timer);
+
+    // save seeds to file
+    ostringstream seed_list;
 
     seed_list << "seed_x,seed_y";
 
     for (int i = 0; i < vcells.size(); i++) {
         seed_list << "\n" << vcells[i].seed.x << "," << vcells[i].seed.y;
     }
-    seed_list.close();
+    write_mesh_file("files/seed_list" + to_string(nr) + ".csv", seed_list.str(), compress);
 
     // save vertices to file
-    name = "files/vertex_list" + to_string(nr) + ".csv";
-
-    ofstream vertex_list(name);
+    ostringstream vertex_list;
 
     vertex_list << "vertex_x,vertex_y";
 
@@ -491,12 +1321,10 @@ void VoronoiMesh::save_mesh_to_files(int nr) {
         }
     }
     
-    vertex_list.close();
+    write_mesh_file("files/vertex_list" + to_string(nr) + ".csv", vertex_list.str(), compress);
 
     // save edges to file
-    name = "files/edge_list" + to_string(nr) + ".csv";
-
-    ofstream edge_list(name);
+    ostringstream edge_list;
 
     edge_list << "edge1_x, edge1_y, edge2_x, edge2_y";
 
@@ -516,11 +1344,22 @@ void VoronoiMesh::save_mesh_to_files(int nr) {
         }
     }
 
-    edge_list.close();
+    write_mesh_file("files/edge_list" + to_string(nr) + ".csv", edge_list.str(), compress);
+
+    VMP_STAT_TIMER_STOP(stats, output_time, output_timer);
+}
+
+// save the mesh to one binary file (files/mesh{nr}.vmsh) with shared vertices and CSR topology, see MappedMesh.h
+void VoronoiMesh::save_mesh_to_binary(int nr) {
+
+    VMP_STAT_TIMER_START(output_timer);
+    CompactMesh cmesh(*this);
+    cmesh.save_mesh_to_binary("files/mesh" + to_string(nr) + ".vmsh");
+    VMP_STAT_TIMER_STOP(stats, output_time, output_timer);
 
 }
 
-// check equidistance
+// check equidistance against all seeds (O(n^2), reference for check_equidistance_local)
 bool VoronoiMesh::check_equidistance() {
     bool correct_mesh = true;
 
@@ -539,6 +1378,79 @@ bool VoronoiMesh::check_equidistance() {
     return correct_mesh;
 }
 
+// check equidistance, but every vertex only against the seeds of its cell, the neighbours and their neighbours.
+// in a correct mesh the three closest seeds of a vertex are among them (check_empty_circle makes sure no other
+// seed is closer), so the check is O(n) and runs in parallel over the cells
+bool VoronoiMesh::check_equidistance_local(int n_threads) {
+
+    ThreadPool pool(n_threads);
+    vector<char> thread_correct(pool.nr_threads, 1);
+
+    pool.parallel_for(vcells.size(), 0, [&](int begin, int end, int thread_id) {
+
+        vector<int> seed_indices;
+
+        for (int i = begin; i < end; i++) {
+
+            // collect the seeds of the cell, its neighbours and the neighbours of the neighbours
+            seed_indices.clear();
+            seed_indices.push_back(i);
+            for (int j = 0; j < vcells[i].edges.size(); j++) {
+                int n = vcells[i].edges[j].index2;
+                if (n < 0) {
+                    continue;
+                }
+                seed_indices.push_back(n);
+                for (int k = 0; k < vcells[n].edges.size(); k++) {
+                    if (vcells[n].edges[k].index2 >= 0) {
+                        seed_indices.push_back(vcells[n].edges[k].index2);
+                    }
+                }
+            }
+            sort(seed_indices.begin(), seed_indices.end());
+            seed_indices.erase(unique(seed_indices.begin(), seed_indices.end()), seed_indices.end());
+
+            if (!vcells[i].check_equidistance_condition(pts, seed_indices)) {
+                thread_correct[thread_id] = 0;
+            }
+        }
+    });
+
+    for (int t = 0; t < thread_correct.size(); t++) {
+        if (!thread_correct[t]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// check that the circle around every inner vertex through the seeds of its cell contains no other seed.
+// the seeds close to a vertex are looked up in a SeedGrid, so this is O(n) as well and parallel over the cells
+bool VoronoiMesh::check_empty_circle(int n_threads) {
+
+    SeedGrid grid(pts, 2);
+    ThreadPool pool(n_threads);
+    vector<char> thread_correct(pool.nr_threads, 1);
+
+    pool.parallel_for(vcells.size(), 0, [&](int begin, int end, int thread_id) {
+
+        vector<int> buffer;
+
+        for (int i = begin; i < end; i++) {
+            if (!vcells[i].check_empty_circle_condition(pts, grid, buffer)) {
+                thread_correct[thread_id] = 0;
+            }
+        }
+    });
+
+    for (int t = 0; t < thread_correct.size(); t++) {
+        if (!thread_correct[t]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // add up areas of all cells
 double VoronoiMesh::check_area() {
 
@@ -600,35 +1512,238 @@ bool VoronoiMesh::check_neighbours() {
     return all_neighbours_known;
 }
 
+// one iteration of lloyd relaxation: move every seed to the centroid of its cell and repair the mesh starting from
+// the current topology (update_mesh), the displacements shrink from iteration to iteration as the mesh converges
+lloyd_step VoronoiMesh::do_lloyd_iteration(int n_threads) {
+
+    int N = vcells.size();
+    vector<Point> centroids(N);
+    vector<double> squared_displacement(N);
+
+    ThreadPool pool(n_threads);
+    pool.parallel_for(N, 0, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++) {
+            centroids[i] = vcells[i].get_centroid();
+            squared_displacement[i] = (centroids[i].x - pts[i].x)*(centroids[i].x - pts[i].x)
+                                    + (centroids[i].y - pts[i].y)*(centroids[i].y - pts[i].y);
+        }
+    });
+
+    double sum = 0;
+    double max_squared = 0;
+    for (int i = 0; i < N; i++) {
+        sum += squared_displacement[i];
+        max_squared = max(max_squared, squared_displacement[i]);
+    }
+
+    lloyd_step step;
+    double spacing = 1.0 / sqrt(max(N, 1));
+    step.rms_displacement = sqrt(sum / max(N, 1)) / spacing;
+    step.max_displacement = sqrt(max_squared) / spacing;
+    step.nr_rebuilt_cells = update_mesh(centroids, n_threads);
+
+    return step;
+}
+
+// hash of a directed edge between two cells
+static inline uint64_t edge_pair_hash(uint64_t from, uint64_t to) {
+
+    // splitmix64 finalizer
+    uint64_t z = (from << 32 | to) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// neumaier summation: add value to sum and keep the lost low order bits in compensation
+static inline void compensated_add(double &sum, double &compensation, double value) {
+
+    double t = sum + value;
+    if (fabs(sum) >= fabs(value)) {
+        compensation += (sum - t) + value;
+    } else {
+        compensation += (value - t) + sum;
+    }
+    sum = t;
+}
+
+// true if the polygon turns right (or goes straight) at every vertex and runs clockwise like all cells
+static bool is_convex_clockwise(const VertexList &verticies) {
+
+    int m = verticies.size();
+    if (m < 3) {
+        return false;
+    }
+
+    double twice_area = 0;
+    for (int j = 0; j < m; j++) {
+
+        const Point &a = verticies[j];
+        const Point &b = verticies[(j + 1) % m];
+        const Point &c = verticies[(j + 2) % m];
+
+        double ux = b.x - a.x;
+        double uy = b.y - a.y;
+        double vx = c.x - b.x;
+        double vy = c.y - b.y;
+
+        // tolerance relative to the edge lengths, nearly collinear vertices are fine
+        double cross = ux * vy - uy * vx;
+        if (cross > 0.000000001 * sqrt((ux*ux + uy*uy) * (vx*vx + vy*vy))) {
+            return false;
+        }
+        twice_area += a.x * b.y - b.x * a.y;
+    }
+
+    return twice_area < 0;
+}
+
+// area, neighbour symmetry, convexity and orientation of all cells in one parallel pass over the cells.
+// every edge i -> n adds hash(i, n) and subtracts hash(n, i), so the total is zero if all neighbours know each other.
+// only if it is not the cells are searched again for the ones with a missing counterpart
+mesh_validation VoronoiMesh::validate_mesh(int n_threads) {
+
+    int N = vcells.size();
+    ThreadPool pool(n_threads);
+    int T = pool.nr_threads;
+
+    vector<double> area_sum(T, 0);
+    vector<double> area_compensation(T, 0);
+    vector<uint64_t> edge_hash(T, 0);
+    vector<long long> nr_edges(T, 0);
+    vector<long long> nr_non_convex(T, 0);
+    vector<int> first_non_convex(T, N);
+
+    pool.parallel_for(N, 0, [&](int begin, int end, int thread_id) {
+        for (int i = begin; i < end; i++) {
+
+            const VoronoiCell &cell = vcells[i];
+            compensated_add(area_sum[thread_id], area_compensation[thread_id], vcells[i].get_area());
+
+            for (int j = 0; j < cell.edges.size(); j++) {
+                int n = cell.edges[j].index2;
+                if (n >= 0) {
+                    edge_hash[thread_id] += edge_pair_hash(i, n) - edge_pair_hash(n, i);
+                    nr_edges[thread_id] += 1;
+                }
+            }
+
+            if (!is_convex_clockwise(cell.verticies)) {
+                nr_non_convex[thread_id] += 1;
+                first_non_convex[thread_id] = min(first_non_convex[thread_id], i);
+            }
+        }
+    });
+
+    mesh_validation result;
+    double area_total = 0;
+    double area_total_compensation = 0;
+    uint64_t hash_total = 0;
+    result.nr_edges = 0;
+    result.nr_non_convex_cells = 0;
+    result.first_non_convex_cell = N;
+    for (int t = 0; t < T; t++) {
+        compensated_add(area_total, area_total_compensation, area_sum[t]);
+        compensated_add(area_total, area_total_compensation, area_compensation[t]);
+        hash_total += edge_hash[t];
+        result.nr_edges += nr_edges[t];
+        result.nr_non_convex_cells += nr_non_convex[t];
+        result.first_non_convex_cell = min(result.first_non_convex_cell, first_non_convex[t]);
+    }
+    result.total_area = area_total + area_total_compensation;
+    result.neighbours_symmetric = (hash_total == 0);
+    result.nr_unmatched_cells = 0;
+    result.first_unmatched_cell = N;
+
+    // find the cells with a neighbour that does not know them
+    if (!result.neighbours_symmetric) {
+
+        vector<long long> nr_unmatched(T, 0);
+        vector<int> first_unmatched(T, N);
+
+        pool.parallel_for(N, 0, [&](int begin, int end, int thread_id) {
+            for (int i = begin; i < end; i++) {
+                for (int j = 0; j < vcells[i].edges.size(); j++) {
+
+                    int n = vcells[i].edges[j].index2;
+                    if (n < 0) {
+                        continue;
+                    }
+
+                    bool known = false;
+                    for (int k = 0; k < vcells[n].edges.size() && !known; k++) {
+                        known = vcells[n].edges[k].index2 == i;
+                    }
+                    if (!known) {
+                        nr_unmatched[thread_id] += 1;
+                        first_unmatched[thread_id] = min(first_unmatched[thread_id], i);
+                        break;
+                    }
+                }
+            }
+        });
+
+        for (int t = 0; t < T; t++) {
+            result.nr_unmatched_cells += nr_unmatched[t];
+            result.first_unmatched_cell = min(result.first_unmatched_cell, first_unmatched[t]);
+        }
+    }
+
+    if (result.first_unmatched_cell == N) {
+        result.first_unmatched_cell = -1;
+    }
+    if (result.first_non_convex_cell == N) {
+        result.first_non_convex_cell = -1;
+    }
+
+    return result;
+}
+
 // check some conditions for mesh
-bool VoronoiMesh::check_mesh() {
+bool VoronoiMesh::check_mesh(int n_threads) {
 
     cout << "checking mesh..." << endl;
 
     bool correct_mesh = true;
 
-    // first check : equidistance
+    // first check : equidistance (local)
     bool equidist = true;
-    if (!check_equidistance()) {
+    if (!check_equidistance_local(n_threads)) {
         correct_mesh = false;
         equidist = false;
     }
     cout << "equidistance condition: " << boolalpha << equidist << endl;
+
+    // no seed closer to a vertex than the seeds it is equidistant to
+    bool empty_circle = true;
+    if (!check_empty_circle(n_threads)) {
+        correct_mesh = false;
+        empty_circle = false;
+    }
+    cout << "empty circle condition: " << boolalpha << empty_circle << endl;
     
-    // second check : area
-    double total_area = check_area();
+    // area, neighbours and shape of the cells in one pass
+    mesh_validation validation = validate_mesh(n_threads);
+
+    double total_area = validation.total_area;
     cout << "total area = " << total_area << "+" << total_area - 1 << endl;
     if (total_area > 1 + 0.000001 || total_area < 1 - 0.000001) {
         correct_mesh = false;
     }
 
-    // third check : neighbours
-    bool neighbour = true;
-    if (!check_neighbours()) {
+    cout << "neighbour condition: " << boolalpha << validation.neighbours_symmetric;
+    if (!validation.neighbours_symmetric) {
         correct_mesh = false;
-        neighbour = false;
+        cout << "  (" << validation.nr_unmatched_cells << " cells, first: " << validation.first_unmatched_cell << ")";
     }
-    cout << "neighbour condition: " << boolalpha << neighbour << endl;
+    cout << endl;
+
+    cout << "convexity condition: " << boolalpha << (validation.nr_non_convex_cells == 0);
+    if (validation.nr_non_convex_cells > 0) {
+        correct_mesh = false;
+        cout << "  (" << validation.nr_non_convex_cells << " cells, first: " << validation.first_non_convex_cell << ")";
+    }
+    cout << endl;
 
     // return total check outcome
     return correct_mesh;
@@ -640,6 +1755,26 @@ void VoronoiMesh::optimize_mesh_memory() {
     pts.shrink_to_fit(); 
     vcells.shrink_to_fit();
 
+#ifdef VMP_CELL_POOL
+    // copy the polygons in cell order into fresh slabs, the slabs of the build are empty afterwards and unmapped
+    CellPool::begin_compaction();
+    for (int i = 0; i<vcells.size(); i++) {
+
+        EdgeList edges(vcells[i].edges.begin(), vcells[i].edges.end());
+        vcells[i].edges.swap(edges);
+        VertexList verticies(vcells[i].verticies.begin(), vcells[i].verticies.end());
+        vcells[i].verticies.swap(verticies);
+        vcells[i].halfplanes.shrink_to_fit();
+
+        // the build allocated the cells roughly in this order too, so its slabs run empty along the way
+        if (i % 16384 == 16383) {
+            CellPool::release_empty_slabs();
+        }
+
+    }
+    CellPool::end_compaction();
+    CellPool::release_empty_slabs();
+#else
     for (int i = 0; i<vcells.size(); i++) {
 
         vcells[i].edges.shrink_to_fit();
@@ -647,6 +1782,7 @@ void VoronoiMesh::optimize_mesh_memory() {
         vcells[i].verticies.shrink_to_fit();
 
     }
+#endif
 
 }
 
@@ -671,4 +1807,4 @@ long long VoronoiMesh::calculate_mesh_memory(bool use_capacity) {
 
     return total_size;
 
-}
\ No newline at end of file
+}
@@ -1,37 +1,97 @@
 #include "VoronoiCell.h"
+#include "HintGrid.h"
+#include "HalfplaneBatch.h"
+#include "MeshStats.h"
+#include "RobustPredicates.h"
 #include "Point.h"
 #include <vector>
 
 #ifndef VoronoiMesh_h
 #define VoronoiMesh_h
 
+// outcome of VoronoiMesh::validate_mesh, cell ids are -1 if no cell failed
+struct mesh_validation
+    {
+        double total_area;              // compensated sum of all cell areas
+        long long nr_edges;             // edges between two cells, counted from both sides
+        bool neighbours_symmetric;      // every neighbour of a cell has that cell as neighbour as well
+        long long nr_unmatched_cells;   // only counted if the neighbours are not symmetric
+        long long nr_non_convex_cells;  // not convex or not clockwise
+        int first_unmatched_cell;
+        int first_non_convex_cell;
+    };
+
+// outcome of one VoronoiMesh::do_lloyd_iteration, displacements in units of the mean seed spacing 1/sqrt(n)
+struct lloyd_step
+    {
+        double rms_displacement;
+        double max_displacement;
+        int nr_rebuilt_cells;
+    };
+
 class VoronoiMesh {
 
 public:
     VoronoiMesh(vector<Point> points);
+    VoronoiMesh(const VoronoiMesh &other) = default;
+    VoronoiMesh(VoronoiMesh &&other) = default;
+    VoronoiMesh &operator=(const VoronoiMesh &other) = default;
+    VoronoiMesh &operator=(VoronoiMesh &&other) = default;
     ~VoronoiMesh();
     vector<Point> pts;
     vector<VoronoiCell> vcells;
     long total_steps;
+    int max_steps;
     int total_frame_counter;
+    bool print_progress;
+    bool brio_insertion;
+    long long triangulation_memory;     // bytes of the Delaunay triangulation of the last build with algorithm 2
+    HintGrid hint_grid;
+    MeshStats stats;
+    void set_points(const Point *points, int n);
+    void set_points(const double *xy, int n);
+    void build(int algorithm, int n_threads = 1, bool optimize_memory = true);
     void construct_mesh();
+    void construct_mesh_parallel(int n_threads);
+    void construct_mesh_delaunay(int n_threads = 1);
+    void construct_mesh_sweepline(int n_threads = 1);
+    void construct_mesh_knn(int n_threads = 1);
     void insert_cell(Point new_seed, int new_seed_index);
-    void save_mesh_to_files(int nr);
+    void trace_new_cell(Point new_seed, int new_seed_index, int cell_im_in_index);
+    void add_traced_cell();
+    void save_mesh_to_files(int nr, bool compress = false);
+    void save_mesh_to_binary(int nr);
     bool check_equidistance();
+    bool check_equidistance_local(int n_threads = 1);
+    bool check_empty_circle(int n_threads = 1);
     double check_area();
     bool check_neighbours();
-    bool check_mesh();
+    mesh_validation validate_mesh(int n_threads = 1);
+    bool check_mesh(int n_threads = 1);
     void do_point_insertion();
+    void do_brio_point_insertion();
+    void do_parallel_point_insertion(int n_threads);
+    int update_mesh(const vector<Point> &new_pts, int n_threads = 1);
+    lloyd_step do_lloyd_iteration(int n_threads = 1);
     int find_cell_index(Point point);
     long long calculate_mesh_memory(bool use_capacity);
     void optimize_mesh_memory();
 private:
-    void find_smallest_pos_intersect(Halfplane &current_hp, int &current_cell_index, VoronoiCell &new_cell, Point &last_vertex, 
-                                        int &last_cell_index, Point &vertex, Halfplane &edge_hp);
-    int get_edge_index_in_cell(int &edge_index, VoronoiCell &vcell);
-    bool intersection_between_start_stop(int index, Point &new_seed, int &new_seed_index, int &next_cell_index, 
-                                            VoronoiCell &new_cell);
+    VoronoiCell trace_cell;
+    vector<intersection> intersection_buffer;
+    HalfplaneBatch edge_batch;
+    int get_edge_index_in_cell(int edge_index, const VoronoiCell &vcell);
+    PredicateSite get_edge_site(const VoronoiCell &vcell, int i);
+    bool vertex_in_conflict(const VoronoiCell &vcell, int i, const PredicateSite &new_site);
+    int find_exit_edge(const VoronoiCell &vcell, int start, const PredicateSite &new_site);
+    int guess_exit_edge(const VoronoiCell &vcell, Point new_seed, int new_seed_index, const PredicateSite &new_site);
+    Point get_intersection_point(Halfplane hp1, Halfplane hp2);
+    void construct_new_cell_fallback(Point new_seed, int new_seed_index);
+    void construct_duplicate_cells(const vector<int> &duplicate_seeds);
 
 };
 
+// text of one csv mesh file, written gzip compressed as name + ".gz" if asked for and zlib is available
+void write_mesh_file(const string &name, const string &content, bool compress);
+
 #endif
\ No newline at end of file
@@ -10,8 +10,19 @@
 #include <algorithm>
 #include <cstring>
 #include <iomanip>
+#include <atomic>
+#include <new>
 #include "Point.h"
 #include "VoronoiMesh.h"
+#include "HalfplaneBatch.h"
+#include "ThreadPool.h"
+#include "SpaceFillingCurve.h"
+#include "CompactMesh.h"
+#include "MeshWriter.h"
+#include "MeshSnapshot.h"
+#include "TiledMesher.h"
+#include "TileRegion.h"
+#include "VoronoiBuilder.h"
 
 
 // ANSI escape codes for text colors
@@ -20,8 +31,84 @@
 #define RESET_COLOR "\033[0m"
 #define GREEN_TEXT "\033[1;32m"
 
+// MEMORY: count heap allocations of the whole program, used to measure the allocations per inserted seed. this
+// replaces the global operator new and delete, so it is only compiled in with the CMake option VMP_COUNT_ALLOCATIONS
+#ifdef VMP_COUNT_ALLOCATIONS
+
+static atomic<long long> heap_allocations(0);
+
+// allocate like the standard operator new: retry through the new handler, nullptr only if there is none
+static void *counted_allocate(size_t size, size_t alignment) {
+
+    heap_allocations.fetch_add(1, memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+
+    while (true) {
+        void *ptr = nullptr;
+        if (alignment <= alignof(max_align_t)) {
+            ptr = malloc(size);
+        } else if (posix_memalign(&ptr, alignment, size) != 0) {
+            ptr = nullptr;
+        }
+        if (ptr != nullptr) {
+            return ptr;
+        }
+        new_handler handler = get_new_handler();
+        if (handler == nullptr) {
+            return nullptr;
+        }
+        handler();
+    }
+}
+
+static void *counted_allocate_or_throw(size_t size, size_t alignment) {
+    void *ptr = counted_allocate(size, alignment);
+    if (ptr == nullptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new(size_t size) { return counted_allocate_or_throw(size, 0); }
+void *operator new[](size_t size) { return counted_allocate_or_throw(size, 0); }
+void *operator new(size_t size, align_val_t alignment) { return counted_allocate_or_throw(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, align_val_t alignment) { return counted_allocate_or_throw(size, static_cast<size_t>(alignment)); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return counted_allocate(size, 0); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return counted_allocate(size, 0); }
+void *operator new(size_t size, align_val_t alignment, const nothrow_t &) noexcept { return counted_allocate(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, align_val_t alignment, const nothrow_t &) noexcept { return counted_allocate(size, static_cast<size_t>(alignment)); }
+
+// malloc and posix_memalign memory is given back with free, sizes and alignments are not needed
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+void operator delete(void *ptr, align_val_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, align_val_t) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t, align_val_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t, align_val_t) noexcept { free(ptr); }
+void operator delete(void *ptr, const nothrow_t &) noexcept { free(ptr); }
+void operator delete[](void *ptr, const nothrow_t &) noexcept { free(ptr); }
+void operator delete(void *ptr, align_val_t, const nothrow_t &) noexcept { free(ptr); }
+void operator delete[](void *ptr, align_val_t, const nothrow_t &) noexcept { free(ptr); }
+
+long long get_heap_allocations() {
+    return heap_allocations.load(memory_order_relaxed);
+}
+
+#else
+
+// not counted: -1
+long long get_heap_allocations() {
+    return -1;
+}
+
+#endif
+
 // MEMORY: function to print out maximum memory usage
-long long get_maxrss_memory() {
+long long get_maxrss_memory(string label = "max RSS memory size") {
     
     // declare a rusage structure to store resource usage information
     struct rusage usage;
@@ -29,9 +116,9 @@ long long get_maxrss_memory() {
     // get resource usage statistics for the current process
     if (getrusage(RUSAGE_SELF, &usage) == 0) {
     
-        // print the RSS memory size in megabytes
+        // print the RSS memory size in megabytes (ru_maxrss is in kilobytes)
         long long rssmax = usage.ru_maxrss;
-        cout << "max RSS memory size: " << rssmax/1024.0/1024.0 << " MB" << endl;
+        cout << label << ": " << rssmax/1024.0 << " MB" << endl;
         return rssmax;
 
     } else {
@@ -111,6 +198,33 @@ vector<Point> generate_seed_points(int N, bool fixed_random_seed, double min, in
         points.push_back(Point(x, y));
     }
 
+    // sort along a space filling curve with 64 bit keys and a radix sort
+    if (sort_pts && (sort_scheme == 4 || sort_scheme == 5)) {
+
+        chrono::high_resolution_clock::time_point start_time = chrono::high_resolution_clock::now();
+
+        vector<uint64_t> keys(points.size());
+        for (int i = 0; i < points.size(); i++) {
+            if (sort_scheme == 4) {
+                keys[i] = get_hilbert_key(points[i]);
+            } else {
+                keys[i] = get_morton_key(points[i]);
+            }
+        }
+
+        vector<int> order = radix_sort_keys(keys);
+
+        vector<Point> sorted_pts(points.size());
+        for (int i = 0; i < order.size(); i++) {
+            sorted_pts[i] = points[order[i]];
+        }
+
+        chrono::high_resolution_clock::time_point end_time = chrono::high_resolution_clock::now();
+        cout << "presort time: " << chrono::duration_cast<chrono::microseconds>(end_time - start_time).count() << " microseconds" << endl;
+
+        return sorted_pts;
+    }
+
     // if this is true the points will be sorted
     if (sort_pts) {
         vector<int> indices;
@@ -169,14 +283,128 @@ vector<Point> generate_uniform_seed_points(int N_approx, double min, double max)
 
 }
 
+// OUTPUT: save the mesh in the chosen format (0: csv seed/vertex/edge lists, 1: binary mesh file, 2: compressed snapshot)
+void save_mesh(VoronoiMesh &vmesh, int nr, int output_format, bool compress = false, int snapshot_bits = 20) {
+
+    if (output_format == 1) {
+        vmesh.save_mesh_to_binary(nr);
+    } else if (output_format == 2) {
+        CompactMesh cmesh(vmesh);
+        MeshSnapshot snapshot(snapshot_bits);
+        snapshot.save(cmesh, "files/mesh" + to_string(nr) + ".vmsnap");
+    } else {
+        vmesh.save_mesh_to_files(nr, compress && MeshWriter::compression_available());
+    }
+}
+
+// OUTPUT: save the mesh as compressed snapshot, read it back and print the compression, the throughput and the round trip error
+void save_snapshot_with_report(VoronoiMesh &vmesh, int nr, int snapshot_bits) {
+
+    CompactMesh cmesh(vmesh);
+    MeshSnapshot snapshot(snapshot_bits);
+    string filename = "files/mesh" + to_string(nr) + ".vmsnap";
+    if (!snapshot.save(cmesh, filename)) {
+        cout << RED_TEXT << "snapshot could not be written" << RESET_COLOR << endl;
+        return;
+    }
+    snapshot_report saved = snapshot.report;
+
+    CompactMesh loaded;
+    if (!snapshot.load(filename, loaded)) {
+        cout << RED_TEXT << "snapshot could not be read back" << RESET_COLOR << endl;
+        return;
+    }
+    snapshot_report read = snapshot.report;
+
+    double raw_mb = saved.raw_bytes/1024.0/1024.0;
+    cout << "snapshot: " << saved.compressed_bytes/1024.0/1024.0 << "MB (binary mesh " << raw_mb << "MB, ratio "
+         << static_cast<double>(saved.raw_bytes)/saved.compressed_bytes << ", " << 8.0*saved.compressed_bytes/cmesh.get_nr_cells() << " bits per cell)" << endl;
+    cout << "snapshot encoding: " << raw_mb/saved.seconds << " MB/s  decoding: " << raw_mb/read.seconds << " MB/s" << endl;
+
+    double error = MeshSnapshot::get_round_trip_error(cmesh, loaded);
+    if (error >= 0 && error <= snapshot.get_error_bound() * (1 + 1e-9)) {
+        cout << "snapshot round trip error: " << GREEN_TEXT << error << RESET_COLOR << " (bound " << snapshot.get_error_bound() << " for " << snapshot_bits << " bits)" << endl;
+    } else {
+        cout << "snapshot round trip error: " << RED_TEXT << error << RESET_COLOR << " (bound " << snapshot.get_error_bound() << " for " << snapshot_bits << " bits, -1: topology changed)" << endl;
+    }
+}
+
+// OUT OF CORE: generate the seeds chunk by chunk into the tile files of a TiledMesher and mesh them tile by tile. only
+// one chunk of seeds and n_threads tile meshes are in memory at a time, the cells are written to files/mesh0.vmcs
+void generate_tiled_mesh(long long N, bool fixed_random_seed, int rd_seed, long long seeds_per_tile, int n_threads, bool check) {
+
+    // same seeds as generate_seed_points without sorting
+    unsigned int random_seed;
+    if (fixed_random_seed) {
+        random_seed = rd_seed;
+    } else {
+        random_device rd;
+        random_seed = rd();
+    }
+    default_random_engine eng(random_seed);
+    uniform_real_distribution<double> distr(0, 1);
+
+    int tiles_per_dim = TiledMesher::get_tiles_per_dim(N, seeds_per_tile);
+    TiledMesher mesher(tiles_per_dim, TileRegion::get_halo_width(N), "files", n_threads);
+
+    cout << "binning seeds into " << tiles_per_dim * tiles_per_dim << " tiles..." << endl;
+    const long long chunk_size = 1000000;
+    vector<Point> chunk;
+    for (long long first = 0; first < N; first += chunk_size) {
+        long long n = min(chunk_size, N - first);
+        chunk.resize(n);
+        for (long long i = 0; i < n; i++) {
+            double x = distr(eng);
+            double y = distr(eng);
+            chunk[i] = Point(x, y);
+        }
+        mesher.add_seeds(chunk.data(), n, first);
+    }
+    vector<Point>().swap(chunk);
+
+    cout << "meshing tiles..." << endl;
+    bool success = mesher.build("files/mesh0.vmcs");
+    const tiled_report &report = mesher.report;
+
+    cout << "binning: " << report.binning_time << " s  meshing: " << report.meshing_time << " s" << endl;
+    cout << "cells written: " << report.nr_cells << " of " << N << "  (" << static_cast<double>(report.nr_cell_entries)/max(report.nr_cells, 1LL) << " edges per cell)" << endl;
+    cout << "ghost seeds: " << static_cast<double>(report.nr_halo_seeds)/N * 100 << " %  halo growths: " << report.nr_halo_growths
+         << "  largest tile mesh: " << report.max_tile_seeds << " seeds" << endl;
+    get_maxrss_memory("max RSS memory size after build");
+
+    // streaming check: every cell written once and together they cover the unit square
+    if (check) {
+        bool tests = success && report.nr_cells == N && fabs(report.total_area - 1) < 1e-9;
+        cout << "total area: " << setprecision(15) << report.total_area << setprecision(6) << endl;
+        if (tests) {
+            cout << "all tests: " << boolalpha << GREEN_TEXT << tests << RESET_COLOR << endl;
+        } else {
+            cout << "all tests: " << boolalpha << RED_TEXT << tests << RESET_COLOR << endl;
+        }
+    } else if (!success) {
+        cout << RED_TEXT << "tiled mesh generation failed" << RESET_COLOR << endl;
+    }
+}
+
 // ANIMATION: generates moving mesh and stores it frame by frame in files
-void generate_animation_files(int frames, int seeds, bool fixed_seed, int rd_seed) {
+void generate_animation_files(int frames, int seeds, bool fixed_seed, int rd_seed, int output_format, bool compress, bool incremental, int n_threads, int snapshot_bits, double step_size) {
     
     // generate initial points and velocities for mesh
     int N_seeds = seeds;
     vector<Point> pts = generate_seed_points(N_seeds, fixed_seed, 0, 1, rd_seed, true, 1000, 1);
     vector<Point> vel = generate_seed_points(N_seeds, fixed_seed, -1, 1, rd_seed, false, 1000, 0);
 
+    // largest step per frame and coordinate, 0.005 of the box or step_size times the mean seed spacing
+    double dt = (step_size > 0) ? step_size / sqrt(N_seeds) : 0.005;
+
+    // frames are written on a background thread while the next one is built (at most 2 finished frames wait in memory)
+    MeshWriter writer(output_format, compress, 2, snapshot_bits);
+    auto start = chrono::high_resolution_clock::now();
+
+    // incremental: the mesh of the last frame is kept and only repaired where the topology changed
+    VoronoiMesh vmesh(pts);
+    long long rebuilt_cells = 0;
+
     // for each frame generate mesh and store it in files
     for (int i = 0; i < frames; i++) {
         
@@ -184,36 +412,58 @@ void generate_animation_files(int frames, int seeds, bool fixed_seed, int rd_see
         for (int j = 0; j < N_seeds; j++) {
 
             // update positions according to velocity
-            pts[j].x = pts[j].x + vel[j].x * 0.005;
-            pts[j].y = pts[j].y + vel[j].y * 0.005;
+            pts[j].x = pts[j].x + vel[j].x * dt;
+            pts[j].y = pts[j].y + vel[j].y * dt;
 
             // change velocities at boundary
             if (pts[j].x < 0 || pts[j].x > 1) {
                 vel[j].x = -vel[j].x;
-                pts[j].x = pts[j].x + 2 * vel[j].x * 0.005;
+                pts[j].x = pts[j].x + 2 * vel[j].x * dt;
             }
             if (pts[j].y < 0 || pts[j].y > 1) {
                 vel[j].y = -vel[j].y;
-                pts[j].y = pts[j].y + 2 * vel[j].y * 0.005;
+                pts[j].y = pts[j].y + 2 * vel[j].y * dt;
             }
 
         }
 
         // construct mesh
-        VoronoiMesh vmesh(pts);
-        vmesh.do_point_insertion();
-        vmesh.save_mesh_to_files(i);
+        // the incremental mesh is still needed for the next frame, the writer gets a flat snapshot of it
+        if (incremental && i > 0) {
+            rebuilt_cells += vmesh.update_mesh(pts, n_threads);
+            writer.add_mesh(CompactMesh(vmesh), i);
+        } else {
+            vmesh = VoronoiMesh(pts);
+            vmesh.do_point_insertion();
+            if (incremental) {
+                writer.add_mesh(CompactMesh(vmesh), i);
+            } else {
+                writer.add_mesh(move(vmesh), i);
+            }
+        }
         cout << fixed << (i+1) << "/" << (frames) << "\r";
         cout.flush();
 
     }
 
+    writer.finish();
+    auto end = chrono::high_resolution_clock::now();
+
     cout << endl;
+    cout << "animation files: " << chrono::duration<double>(end - start).count() << " s (waited " << writer.get_wait_time() << " s for the writer)" << endl;
+    if (output_format == 2) {
+        snapshot_report total = writer.get_snapshot_report();
+        cout << "snapshots: " << total.compressed_bytes/1024.0/1024.0 << "MB (ratio " << static_cast<double>(total.raw_bytes)/total.compressed_bytes
+             << " to binary mesh files, encoding " << total.raw_bytes/1024.0/1024.0/total.seconds << " MB/s)" << endl;
+    }
+    if (incremental && frames > 1) {
+        cout << "incremental update: " << rebuilt_cells / (frames - 1) << " cells rebuilt per frame (of " << N_seeds << ")" << endl;
+    }
 
 }
 
 // ANIMATION: function to generate files for animation of grid construction
-void animate_algorithm(int N_seeds, int rd_seed, int algorithm, bool sort, int sort_scheme) {
+void animate_algorithm(int N_seeds, int rd_seed, int algorithm, bool sort, int sort_scheme, int output_format, int snapshot_bits) {
 
     // generate seed points for animation and its indices
     vector<Point> pts = generate_seed_points(N_seeds, true, 0, 1, rd_seed, sort, sqrt(N_seeds), sort_scheme);
@@ -240,7 +490,7 @@ void animate_algorithm(int N_seeds, int rd_seed, int algorithm, bool sort, int s
             VoronoiCell vcell(pts[i-1], i-1);
             vcell.construct_cell(pts, indices);
             vmesh_hp_intersect.vcells.push_back(vcell);
-            vmesh_hp_intersect.save_mesh_to_files(i-1);
+            save_mesh(vmesh_hp_intersect, i-1, output_format, false, snapshot_bits);
 
         // algorithm != 0 : point insertion
         } else {
@@ -252,7 +502,7 @@ void animate_algorithm(int N_seeds, int rd_seed, int algorithm, bool sort, int s
             } else {
                 vmesh.do_point_insertion();
             }
-            vmesh.save_mesh_to_files(i-1);
+            save_mesh(vmesh, i-1, output_format, false, snapshot_bits);
         }
         cout << fixed << i << "/" << N_seeds-1 << "\r";
         cout.flush();
@@ -263,8 +513,30 @@ void animate_algorithm(int N_seeds, int rd_seed, int algorithm, bool sort, int s
 
 }
 
+// LLOYD: relax the mesh towards a centroidal voronoi mesh, every iteration repairs the mesh of the last one.
+// prints the displacement of the seeds (in units of the mean seed spacing) and the time per iteration, saved in csv
+void do_lloyd_relaxation(VoronoiMesh &vmesh, int iterations, int n_threads) {
+
+    ofstream lloyd_list("benchmarks/lloyd.csv");
+    lloyd_list << "iteration,rms_displacement,max_displacement,rebuilt_cells,time_in_microseconds\n";
+
+    for (int i = 1; i <= iterations; i++) {
+
+        chrono::high_resolution_clock::time_point start_time = chrono::high_resolution_clock::now();
+        lloyd_step step = vmesh.do_lloyd_iteration(n_threads);
+        chrono::high_resolution_clock::time_point end_time = chrono::high_resolution_clock::now();
+        chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(end_time - start_time);
+
+        cout << "lloyd iteration " << i << ": rms displacement " << step.rms_displacement << " (max " << step.max_displacement << ")  rebuilt cells: "
+             << step.nr_rebuilt_cells << "  time: " << duration.count() << " microseconds" << endl;
+        lloyd_list << i << "," << step.rms_displacement << "," << step.max_displacement << "," << step.nr_rebuilt_cells << "," << duration.count() << "\n";
+    }
+
+    lloyd_list.close();
+}
+
 // BENCHMARKING: function to benchmark the mesh generation algorithm, saves times in csv
-void do_benchmarking(string output_file, vector<int> seedvalues, bool append, int algorithm, bool sort, int sort_scheme, bool fixed_seed, int rd_seed) {
+void do_benchmarking(string output_file, vector<int> seedvalues, bool append, int algorithm, bool sort, int sort_scheme, bool fixed_seed, int rd_seed, int n_threads) {
 
     ofstream timing_list;
 
@@ -273,13 +545,20 @@ void do_benchmarking(string output_file, vector<int> seedvalues, bool append, in
         timing_list =  ofstream("benchmarks/time_" + output_file, ios::app);
     } else {
         timing_list = ofstream("benchmarks/time_" + output_file);
-        timing_list << "nr_seeds,time_in_microseconds\n";
+        timing_list << "nr_seeds,time_in_microseconds,total_steps,steps_per_insert,max_steps,heap_allocations\n";
     }
 
     ofstream memory_list;
     memory_list = ofstream("benchmarks/memory_" + output_file);
     memory_list << "nr_seeds,rss_memory_usage_in_bytes\n";
 
+    // only for the delaunay algorithm: comparison with the point insertion
+    ofstream compare_list;
+    if (algorithm == 2) {
+        compare_list = ofstream("benchmarks/compare_" + output_file);
+        compare_list << "nr_seeds,delaunay_time_in_microseconds,point_insertion_time_in_microseconds,triangulation_bytes,delaunay_mesh_bytes,point_insertion_mesh_bytes\n";
+    }
+
     cout << "Start Benchmarking: 0 to " << seedvalues.size()-1 << endl;
 
     // do benchmark for each seedvalue size
@@ -293,14 +572,11 @@ void do_benchmarking(string output_file, vector<int> seedvalues, bool append, in
         chrono::high_resolution_clock::time_point start_time = chrono::high_resolution_clock::now();
 
         // construct mesh
+        long long allocations_before = get_heap_allocations();
         VoronoiMesh* vmesh = new VoronoiMesh(pts);
         //VoronoiMesh vmesh(pts);
-        if (algorithm == 0) {
-            vmesh->construct_mesh();
-            //vmesh.construct_mesh();
-        } else {
-            vmesh->do_point_insertion();
-        }
+        vmesh->build(algorithm, n_threads);
+        long long allocations = (allocations_before < 0) ? -1 : get_heap_allocations() - allocations_before;
 
         // get current time point
         chrono::high_resolution_clock::time_point end_time = chrono::high_resolution_clock::now();
@@ -309,28 +585,117 @@ void do_benchmarking(string output_file, vector<int> seedvalues, bool append, in
         chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(end_time - start_time);
 
         // save to file
-        timing_list << N_seeds << "," << duration.count() << "\n";
+        timing_list << N_seeds << "," << duration.count() << "," << vmesh->total_steps << "," << static_cast<double>(vmesh->total_steps)/max(N_seeds - 3, 1) << "," << vmesh->max_steps << "," << allocations << "\n";
 
         cout << i << " ->";
 
         // output the duration in microseconds
-        cout << "Seeds: " << N_seeds << "  Execution time: " << duration.count() << " microseconds" << endl;
+        cout << "Seeds: " << N_seeds << "  Execution time: " << duration.count() << " microseconds  total steps: " << vmesh->total_steps << " (" << static_cast<double>(vmesh->total_steps)/max(N_seeds - 3, 1) << " per insert, max " << vmesh->max_steps << ")  heap allocations: " << allocations << " (" << static_cast<double>(allocations)/N_seeds << " per seed)" << endl;
         memory_list << N_seeds << "," <<  get_maxrss_memory() << "\n";
 
         long long total_size = vmesh->calculate_mesh_memory(true);
-        cout << "manual mesh capacity: " << total_size/1024.0/1024.0 << "MB" << endl;
+        CompactMesh cmesh(*vmesh);
+        cout << "manual mesh capacity: " << total_size/1024.0/1024.0 << "MB  compact (CSR) mesh capacity: " << cmesh.calculate_mesh_memory(true)/1024.0/1024.0 << "MB" << endl;
  
         //vmesh.save_mesh_to_files(0);
+        long long triangulation_bytes = vmesh->triangulation_memory;
         delete vmesh;
+
+        // head to head with the point insertion on the same seeds (the triangulation is freed after the dual cells are built)
+        if (algorithm == 2) {
+            chrono::high_resolution_clock::time_point insertion_start = chrono::high_resolution_clock::now();
+            VoronoiMesh* insertion_mesh = new VoronoiMesh(pts);
+            insertion_mesh->build(1, n_threads);
+            chrono::high_resolution_clock::time_point insertion_end = chrono::high_resolution_clock::now();
+            chrono::microseconds insertion_duration = chrono::duration_cast<chrono::microseconds>(insertion_end - insertion_start);
+
+            compare_list << N_seeds << "," << duration.count() << "," << insertion_duration.count() << "," << triangulation_bytes << "," << total_size << "," << insertion_mesh->calculate_mesh_memory(true) << "\n";
+            cout << "point insertion on the same seeds: " << insertion_duration.count() << " microseconds  (speedup of delaunay: " << static_cast<double>(insertion_duration.count())/max(static_cast<long long>(duration.count()), 1LL) << ")  triangulation: " << triangulation_bytes/1024.0/1024.0 << "MB" << endl;
+            delete insertion_mesh;
+        }
     }
 
     timing_list.close();
     memory_list.close();
+    compare_list.close();
 
     cout << "Benchmarking done" << endl;
 
 }
 
+// BENCHMARKING: function to benchmark how the mesh generation scales with the number of threads, saves times and speedups in csv
+void do_thread_benchmarking(string output_file, int N_seeds, int max_threads, int algorithm, bool sort, int sort_scheme, bool fixed_seed, int rd_seed) {
+
+    ofstream thread_list("benchmarks/threads_" + output_file);
+    thread_list << "nr_threads,time_in_microseconds,speedup,efficiency\n";
+
+    // generate seeds once so that every thread count meshes the same points
+    vector<Point> pts = generate_seed_points(N_seeds, fixed_seed, 0, 1, rd_seed, sort, sqrt(N_seeds), sort_scheme);
+
+    // thread counts to test: powers of two up to max_threads and max_threads itself
+    vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    cout << "Start Thread Benchmarking: " << N_seeds << " seeds, 1 to " << max_threads << " threads" << endl;
+
+    double serial_time = 0;
+    VoronoiMesh* reference = nullptr;
+
+    for (int i = 0; i < thread_counts.size(); i++) {
+
+        chrono::high_resolution_clock::time_point start_time = chrono::high_resolution_clock::now();
+
+        VoronoiMesh* vmesh = new VoronoiMesh(pts);
+        vmesh->build(algorithm, thread_counts[i]);
+
+        chrono::high_resolution_clock::time_point end_time = chrono::high_resolution_clock::now();
+        chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(end_time - start_time);
+
+        if (i == 0) {
+            serial_time = duration.count();
+        }
+        double speedup = serial_time / static_cast<double>(duration.count());
+        double efficiency = speedup / thread_counts[i];
+
+        // the parallel build has to give the same mesh as the serial one (point insertion on tiles may differ in the last bits)
+        double tolerance = (algorithm == 0 || algorithm == 4) ? 0 : 1e-12;
+        bool identical = true;
+        if (reference == nullptr) {
+            reference = vmesh;
+        } else {
+            identical = (reference->vcells.size() == vmesh->vcells.size());
+            for (int j = 0; j < reference->vcells.size() && identical; j++) {
+                VoronoiCell &a = reference->vcells[j];
+                VoronoiCell &b = vmesh->vcells[j];
+                if (a.verticies.size() != b.verticies.size()) {
+                    identical = false;
+                    break;
+                }
+                for (int k = 0; k < a.verticies.size(); k++) {
+                    if (fabs(a.verticies[k].x - b.verticies[k].x) > tolerance || fabs(a.verticies[k].y - b.verticies[k].y) > tolerance || a.edges[k].index2 != b.edges[k].index2) {
+                        identical = false;
+                        break;
+                    }
+                }
+            }
+            delete vmesh;
+        }
+
+        thread_list << thread_counts[i] << "," << duration.count() << "," << speedup << "," << efficiency << "\n";
+        cout << "Threads: " << thread_counts[i] << "  Execution time: " << duration.count() << " microseconds  speedup: " << speedup 
+             << "  efficiency: " << efficiency << "  same mesh as serial: " << boolalpha << identical << endl;
+    }
+
+    delete reference;
+    thread_list.close();
+
+    cout << "Thread Benchmarking done" << endl;
+
+}
+
 // CLI: test wether part of command line input is integer
 bool is_integer(const string& str) {
     try {
@@ -346,6 +711,18 @@ bool is_integer(const string& str) {
     }
 }
 
+// CLI: test wether part of command line input is a (floating point) number
+bool is_number(const string& str) {
+    try {
+        stod(str);
+        return true;
+    } catch (const invalid_argument& e) {
+        return false;
+    } catch (const out_of_range& e) {
+        return false;
+    }
+}
+
 // MAIN :  -------------------------------------------------------------------------------------------------------
 int main (int argc, char *argv[]) {
 
@@ -371,11 +748,23 @@ int main (int argc, char *argv[]) {
     int sort_scheme = 1;
     bool check_option = false;
     int run_option = 0;         // run options: 0: normal_mesh, 1: benchmark, 2: moving mesh animation, 3: grid generation animation
-    int algorithm = 1;      // 1: pt_insertion, 0: hp_intersection, rest: also pt_insertion
+    int algorithm = 1;      // 1: pt_insertion, 0: hp_intersection, 2: delaunay, 3: sweepline, 4: knn clipping, rest: also pt_insertion
     bool image_condition = false;
     bool need_help = false;
     int frames = 100;
     int fps = 20;
+    int n_threads = 1;
+    int output_format = 0;
+    int snapshot_bits = 20;
+    bool tiled_option = false;
+    long long seeds_per_tile = 1000000;
+    bool compress = false;
+    bool incremental = false;
+    double step_size = 0;
+    bool stats_option = false;
+    int lloyd_iterations = 0;
+    bool brio_option = false;
+    bool uniform_grid = false;
 
 
     // READ OUT CLI to start program with correct options
@@ -429,14 +818,14 @@ int main (int argc, char *argv[]) {
                 }
                 cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Sort Option = " << sort << endl;
             } else {
-                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Sort scheme is not a valid integer. Use: -sort (0, 1, 2, 3) where" << 
-                        endl << setw(11) << "" << "0:no sort, 1: modulo sort, 2: radially outward, 3: radially inward" << endl;
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Sort scheme is not a valid integer. Use: -sort (0, 1, 2, 3, 4, 5) where" << 
+                        endl << setw(11) << "" << "0:no sort, 1: modulo sort, 2: radially outward, 3: radially inward, 4: hilbert curve, 5: morton curve" << endl;
                 cout << setw(11) << "" << "Continuing with standard sort option: 1 -> modulo sort" << endl;
             }
         } else if (strcmp(argv[i], "-sort_option") == 0 && argc <= i+1) {
             found_command = true;
-            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "did not specify an sort scheme after using -sort. Use: -sort (0, 1, 2, 3) where" << 
-                    endl << setw(11) << "" << "0:no sort, 1: modulo sort, 2: radially outward, 3: radially inward" << endl;
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "did not specify an sort scheme after using -sort. Use: -sort (0, 1, 2, 3, 4, 5) where" << 
+                    endl << setw(11) << "" << "0:no sort, 1: modulo sort, 2: radially outward, 3: radially inward, 4: hilbert curve, 5: morton curve" << endl;
             cout << setw(11) << "" << "Continuing with standard sort option: 1 -> modulo sort" << endl;
         }
 
@@ -463,6 +852,144 @@ int main (int argc, char *argv[]) {
             cout << setw(11) << "" << "Continuing with standard algorithm: point_insertion " << endl;
         }
 
+        // option to set the number of threads
+        if (strcmp(argv[i], "-threads") == 0 && argc > i+1) {
+            found_command = true;
+            if (is_integer(argv[i+1]) && stoi(argv[i+1]) >= 0) {
+                n_threads = stoi(argv[i+1]);
+                if (n_threads == 0) {
+                    n_threads = ThreadPool::hardware_threads();
+                }
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Threads = " << n_threads << endl;
+            } else {
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Specified thread number is not a positive integer: " << argv[i] << " " << argv[i+1] << endl;
+                cout << setw(11) << "" << "Continuing with standard value for -threads: " << n_threads << endl;
+            }
+        } else if (strcmp(argv[i], "-threads") == 0 && argc <= i+1) {
+            found_command = true;
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Called -threads but not specified thread number. Use: -threads (your_thread_number) instead" << endl;
+        }
+
+        // option to choose the output file format
+        if (strcmp(argv[i], "-format") == 0 && argc > i+1) {
+            found_command = true;
+            if (is_integer(argv[i+1]) && stoi(argv[i+1]) >= 0 && stoi(argv[i+1]) <= 2) {
+                output_format = stoi(argv[i+1]);
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Output format = " << output_format << endl;
+            } else {
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Specified format is not valid. Use: -format (0, 1, 2) where 0: csv files, 1: binary mesh file, 2: compressed snapshot" << endl;
+                cout << setw(11) << "" << "Continuing with standard format: 0 -> csv files" << endl;
+            }
+        } else if (strcmp(argv[i], "-format") == 0 && argc <= i+1) {
+            found_command = true;
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Called -format but not specified it. Use: -format (0, 1, 2) where 0: csv files, 1: binary mesh file, 2: compressed snapshot" << endl;
+        }
+
+        // option to choose the precision of the compressed snapshots
+        if (strcmp(argv[i], "-snapshot_bits") == 0 && argc > i+1) {
+            found_command = true;
+            if (is_integer(argv[i+1]) && stoi(argv[i+1]) >= 8 && stoi(argv[i+1]) <= 32) {
+                snapshot_bits = stoi(argv[i+1]);
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Snapshot bits per coordinate = " << snapshot_bits << endl;
+            } else {
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Specified snapshot bits are not valid. Use: -snapshot_bits (8 to 32)" << endl;
+                cout << setw(11) << "" << "Continuing with standard precision: 20 bits" << endl;
+            }
+        } else if (strcmp(argv[i], "-snapshot_bits") == 0 && argc <= i+1) {
+            found_command = true;
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Called -snapshot_bits but not specified them. Use: -snapshot_bits (8 to 32) instead" << endl;
+        }
+
+        // option to mesh out of core, tile by tile
+        if (strcmp(argv[i], "-tiles") == 0 && argc > i+1) {
+            found_command = true;
+            if (is_integer(argv[i+1]) && stoll(argv[i+1]) >= 1) {
+                tiled_option = true;
+                seeds_per_tile = stoll(argv[i+1]);
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Out of core mesh generation with " << seeds_per_tile << " seeds per tile" << endl;
+            } else {
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Specified seeds per tile are not a positive integer: " << argv[i] << " " << argv[i+1] << endl;
+                cout << setw(11) << "" << "Continuing with the mesh in memory" << endl;
+            }
+        } else if (strcmp(argv[i], "-tiles") == 0 && argc <= i+1) {
+            found_command = true;
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Called -tiles but not specified the seeds per tile. Use: -tiles (your_seeds_per_tile) instead" << endl;
+        }
+
+        // option to gzip the csv output files
+        if (strcmp(argv[i], "-compress") == 0) {
+            found_command = true;
+            if (MeshWriter::compression_available()) {
+                compress = true;
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Compress output files with gzip" << endl;
+            } else {
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Compression is not available, vmp was built without zlib" << endl;
+                cout << setw(11) << "" << "Continuing with uncompressed output files" << endl;
+            }
+        }
+
+        // option to insert the seeds in biased randomized insertion order
+        if (strcmp(argv[i], "-brio") == 0) {
+            found_command = true;
+            brio_option = true;
+            cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Biased randomized insertion order" << endl;
+        }
+
+        // option to place the seeds on a uniform grid (degenerate input: four seeds on every circle)
+        if (strcmp(argv[i], "-uniform") == 0) {
+            found_command = true;
+            uniform_grid = true;
+            cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Seeds on a uniform grid" << endl;
+        }
+
+        // option to relax the mesh with lloyd iterations
+        if (strcmp(argv[i], "-lloyd") == 0 && argc > i+1) {
+            found_command = true;
+            if (is_integer(argv[i+1]) && stoi(argv[i+1]) >= 0) {
+                lloyd_iterations = stoi(argv[i+1]);
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Lloyd iterations = " << lloyd_iterations << endl;
+            } else {
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Specified number of lloyd iterations is not a positive integer: " << argv[i] << " " << argv[i+1] << endl;
+                cout << setw(11) << "" << "Continuing without lloyd relaxation" << endl;
+            }
+        } else if (strcmp(argv[i], "-lloyd") == 0 && argc <= i+1) {
+            found_command = true;
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Called -lloyd but not specified the number of iterations. Use: -lloyd (your_iterations) instead" << endl;
+        }
+
+        // option to print the hot path counters and phase times
+        if (strcmp(argv[i], "-stats") == 0) {
+            found_command = true;
+            if (MeshStats::compiled_in()) {
+                stats_option = true;
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Mesh statistics" << endl;
+            } else {
+                cout << ORANGE_TEXT << "CLI WARNING: " << RESET_COLOR << "Mesh statistics are not available, vmp was built without VMP_ENABLE_STATS" << endl;
+            }
+        }
+
+        // option to update the moving mesh from frame to frame instead of constructing it again
+        if (strcmp(argv[i], "-incremental") == 0) {
+            found_command = true;
+            incremental = true;
+            cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Incremental moving mesh update" << endl;
+        }
+
+        // option to set the step of the moving mesh per frame in units of the mean seed spacing
+        if (strcmp(argv[i], "-step") == 0 && argc > i+1) {
+            found_command = true;
+            if (is_number(argv[i+1]) && stod(argv[i+1]) > 0) {
+                step_size = stod(argv[i+1]);
+                cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << "Moving mesh step = " << step_size << " seed spacings" << endl;
+            } else {
+                cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Specified step is not a positive number: " << argv[i] << " " << argv[i+1] << endl;
+                cout << setw(11) << "" << "Continuing with the default step" << endl;
+            }
+        } else if (strcmp(argv[i], "-step") == 0 && argc <= i+1) {
+            found_command = true;
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Called -step but not specified the step. Use: -step (your_step) instead" << endl;
+        }
+
         // option to directly plot image of generated mesh
         if (strcmp(argv[i], "-image") == 0) {
             found_command = true;
@@ -563,15 +1090,36 @@ int main (int argc, char *argv[]) {
             cout << setw(21) << "" << "1 - modulo sort (standard option)" << endl;
             cout << setw(21) << "" << "2 - radially outward" << endl;
             cout << setw(21) << "" << "3 - radially inward" << endl;
-            cout << "-check             : check mesh for correctness (for large point sets takes way longer than grid generation)" << endl;
+            cout << setw(21) << "" << "4 - Peano-Hilbert curve" << endl;
+            cout << setw(21) << "" << "5 - Morton (Z-order) curve" << endl;
+            cout << "-check             : check mesh for correctness (local checks, parallel with -threads)" << endl;
             cout << "-algorithm          : specify the algorithm used" << endl;
-            cout << setw(21) << "" << "0 - halfplane intersection O(n^2)" << endl;
+            cout << setw(21) << "" << "0 - halfplane intersection O(n) with seed grid" << endl;
             cout << setw(21) << "" << "1 - point insertion O(nlogn) (standard option)" << endl;
+            cout << setw(21) << "" << "2 - dual of the Delaunay triangulation (Bowyer-Watson), -benchmark compares it to point insertion" << endl;
+            cout << setw(21) << "" << "3 - Fortune sweepline O(nlogn) for any order of the seeds" << endl;
+            cout << setw(21) << "" << "4 - every cell clipped by its k nearest seeds, parallel with -threads" << endl;
+            cout << "-threads           : number of threads used for the mesh generation (0: all hardware threads, standard: 1)" << endl;
+            cout << setw(21) << "" << "with -benchmark also benchmarks the speedup from 1 up to this number of threads" << endl;
+            cout << "-format            : output file format" << endl;
+            cout << setw(21) << "" << "0 - csv seed, vertex and edge lists (standard option)" << endl;
+            cout << setw(21) << "" << "1 - binary mesh file, memory mappable (files/mesh*.vmsh)" << endl;
+            cout << setw(21) << "" << "2 - compressed snapshot, quantized coordinates (files/mesh*.vmsnap, not readable by the python plots)" << endl;
+            cout << "-snapshot_bits     : bits per coordinate of the compressed snapshots (8 to 32, standard: 20)" << endl;
+            cout << "-compress          : gzip the csv output files (*.csv.gz, needs zlib)" << endl;
+            cout << "-brio              : point insertion in biased randomized insertion order, fast for any order of the seeds (serial)" << endl;
+            cout << "-uniform           : seeds on a uniform grid of about (seeds) points instead of random ones (degenerate input)" << endl;
+            cout << "-lloyd             : relax the mesh with (iterations) lloyd iterations after the build, saved to benchmarks/lloyd.csv" << endl;
+            cout << "-tiles             : out of core: mesh (seeds_per_tile) seeds at a time from tile files, cells written to files/mesh0.vmcs" << endl;
+            cout << setw(21) << "" << "point insertion on -threads tiles at once, -check compares the number of cells and their total area" << endl;
+            cout << "-stats             : print counters and phase times of the mesh generation, saved to benchmarks/mesh_stats.json" << endl;
             cout << "-image             : plot image of mesh using python matplotlib and save file" << endl;
             cout << "-benchmark         : benchmark algorithm, save benchmarking files and plot time and memory benchmark using python matplotlib" << endl;
             cout << setw(21) << "" << "! benchmarking is not compatible with -n, -check, -image, - gganim, -mmanim !" << endl;
             cout << "-mmanim            : moving mesh animation, specify (frames) (fps)" << endl;
             cout << setw(21) << "" << "! Moving Mesh Animation is not compatible with -sort_option, -check, -algorithm, -image, -benchmark, -gganim !" << endl;
+            cout << "-incremental       : moving mesh animation keeps the mesh and only repairs cells whose neighbours changed" << endl;
+            cout << "-step              : largest step of the moving mesh per frame in units of the mean seed spacing (default 0.005 of the box)" << endl;
             cout << "-gganim            : grid generation animation, specify (fps)" << endl;
             cout << setw(21) <<  "" << "! Grid Generation Animation is not compatible with -check, -image, -benchmark, -mmanim !" << endl;
             
@@ -587,13 +1135,33 @@ int main (int argc, char *argv[]) {
     }
 
 
+    // the python plots read csv and binary mesh files only
+    if (output_format == 2 && (image_condition || run_option == 2 || run_option == 3) && !need_help) {
+        cout << ORANGE_TEXT << "CLI WARNING: " << RESET_COLOR << "Compressed snapshots can not be plotted, the plots will fail. Use -format 0 or 1 for -image, -mmanim and -gganim" << endl;
+    }
+
+    // only the point insertion runs on the tiles, and the cells go into their own file format
+    if (tiled_option && run_option == 0 && !need_help && (image_condition || algorithm != 1 || output_format != 0 || lloyd_iterations > 0 || uniform_grid)) {
+        cout << ORANGE_TEXT << "CLI WARNING: " << RESET_COLOR << "-tiles always uses point insertion on uniform random seeds and writes files/mesh0.vmcs" << endl;
+        cout << setw(13) << "" << "-algorithm, -format, -image, -lloyd and -uniform are ignored" << endl;
+    }
+
+    // OUT OF CORE: bin the seeds into tile files and mesh tile by tile, the memory is bounded by the tile size
+    if (run_option == 0 && tiled_option && !need_help) {
+        generate_tiled_mesh(N_seeds, fixed_seed, rd_seed, seeds_per_tile, n_threads, check_option);
+    }
+
     // GENERATE MESH: generate voronoi mesh for given seed number and stop time for that
-    if (run_option == 0 && !need_help) {
+    if (run_option == 0 && !tiled_option && !need_help) {
 
         cout << "generating points..." << endl;
 
-        vector<Point> pts = generate_seed_points(N_seeds, fixed_seed, 0, 1, rd_seed, sort, sqrt(N_seeds), sort_scheme);
-        //vector<Point> pts = generate_uniform_seed_points(N_seeds, 0, 1);
+        vector<Point> pts;
+        if (uniform_grid) {
+            pts = generate_uniform_seed_points(N_seeds, 0, 1);
+        } else {
+            pts = generate_seed_points(N_seeds, fixed_seed, 0, 1, rd_seed, sort, sqrt(N_seeds), sort_scheme);
+        }
 
         cout << "start timer..." << endl;
 
@@ -601,12 +1169,13 @@ int main (int argc, char *argv[]) {
         chrono::high_resolution_clock::time_point start_time = chrono::high_resolution_clock::now();
 
         // construct mesh
-        VoronoiMesh vmesh(pts);
-         if (algorithm == 0) {
-            vmesh.construct_mesh();         // <-- O(n^2) scaling half plane intersection
-        } else {
-            vmesh.do_point_insertion();     // <-- O(nlogn) scaling point insertion algoithm
-        }     
+        long long allocations_before = get_heap_allocations();
+        VoronoiBuilder builder(algorithm, n_threads);
+        builder.brio_insertion = brio_option;
+        builder.optimize_memory = true;     // the only mesh of the program, compact it
+        builder.build(pts.data(), pts.size());
+        VoronoiMesh &vmesh = builder.get_voronoi_mesh();
+        long long allocations = get_heap_allocations() - allocations_before;
 
         // get the current time point after the code execution
         chrono::high_resolution_clock::time_point end_time = chrono::high_resolution_clock::now();
@@ -619,14 +1188,34 @@ int main (int argc, char *argv[]) {
         // output the duration in microseconds
         cout << "Execution time: " << duration.count() << " microseconds" << endl;
 
+        // output the walk length of find_cell_index to compare the presort options
+        if (algorithm != 0 && pts.size() > 3) {
+            cout << "total steps: " << vmesh.total_steps << "  (" << static_cast<double>(vmesh.total_steps)/(pts.size() - 3) << " per inserted seed, max " << vmesh.max_steps << ")" << endl;
+        }
+
+        if (allocations_before >= 0) {
+            cout << "heap allocations: " << allocations << "  (" << static_cast<double>(allocations)/pts.size() << " per seed)" << endl;
+        }
+        cout << "intersection kernel: " << HalfplaneBatch::get_kernel_name() << endl;
+        get_maxrss_memory("max RSS memory size after build");
+
+        // OPTIONAL : move the seeds to the centroids of their cells
+        if (lloyd_iterations > 0) {
+            do_lloyd_relaxation(vmesh, lloyd_iterations, n_threads);
+        }
+
         // save mesh to file
         cout << "saving mesh to files..." << endl;
-        vmesh.save_mesh_to_files(0);
+        if (output_format == 2) {
+            save_snapshot_with_report(vmesh, 0, snapshot_bits);
+        } else {
+            save_mesh(vmesh, 0, output_format, compress);
+        }
 
         // OPTIONAL : do correctness checks 
         if (check_option) {
             // check mesh for correctness
-            bool tests = vmesh.check_mesh();                            // <-- usually take longer then generating the grid
+            bool tests = vmesh.check_mesh(n_threads);
             if (tests) {
                 cout << "all tests: " << boolalpha << GREEN_TEXT << tests << RESET_COLOR << endl;
             } else {
@@ -634,15 +1223,28 @@ int main (int argc, char *argv[]) {
             }
         }
 
+        // OPTIONAL : counters and phase times of the hot paths
+        if (stats_option) {
+            vmesh.stats.print();
+            vmesh.stats.save_to_json("benchmarks/mesh_stats.json");
+        }
+
         // OPTIONAL : print out max rss memory usage of the processs
         long long max_memory = get_maxrss_memory();
 
         long long total_capacity = vmesh.calculate_mesh_memory(true);
         cout << "manually calculated mesh capacity: " << total_capacity/1024.0/1024.0 << "MB" << endl;
+        cout << "cell pool slabs: " << CellPool::get_reserved_bytes()/1024.0/1024.0 << "MB" << endl;
+
+        // same mesh in the flat layout with shared vertices
+        const CompactMesh &cmesh = builder.get_mesh();
+        long long compact_capacity = cmesh.calculate_mesh_memory(true);
+        cout << "compact (CSR) mesh capacity: " << compact_capacity/1024.0/1024.0 << "MB  (" << cmesh.vertices.size() << " unique vertices)" << endl;
 
         // Show Image
         if (image_condition) {
-            int result = system("python3 ../visualisation.py -program 0 ");
+            string commandString = "python3 ../visualisation.py -program 0 -format " + to_string(output_format);
+            int result = system(commandString.c_str());
         }
 
 
@@ -668,7 +1270,7 @@ int main (int argc, char *argv[]) {
         seedvals.push_back(3000);
         seedvals.push_back(5000);
         seedvals.push_back(10000);
-        if (algorithm == 1) {
+        if (algorithm != 0) {
             seedvals.push_back(15000);
             seedvals.push_back(20000);
             seedvals.push_back(30000);
@@ -677,6 +1279,10 @@ int main (int argc, char *argv[]) {
             seedvals.push_back(500000);
             seedvals.push_back(1000000);
         }
+        if (algorithm >= 2 && algorithm <= 4) {
+            seedvals.push_back(3000000);
+            seedvals.push_back(10000000);
+        }
         
 
         //seedvals.push_back(10);
@@ -688,7 +1294,12 @@ int main (int argc, char *argv[]) {
         string output = "benchmark.csv";
 
         // do the benchmarking
-        do_benchmarking(output, seedvals, false, algorithm, sort, sort_scheme, fixed_seed, rd_seed);  // first true or false: append or new file
+        do_benchmarking(output, seedvals, false, algorithm, sort, sort_scheme, fixed_seed, rd_seed, n_threads);  // first true or false: append or new file
+
+        // benchmark the speedup with the number of threads for the largest seed number
+        if (n_threads > 1) {
+            do_thread_benchmarking(output, seedvals.back(), n_threads, algorithm, sort, sort_scheme, fixed_seed, rd_seed);
+        }
 
         // Show Benchmarking plots
         int result = system("python3 ../visualisation.py -program 1 ");
@@ -701,10 +1312,10 @@ int main (int argc, char *argv[]) {
 
     // animation for a moving mesh
     if (run_option == 2) {
-        generate_animation_files(frames, N_seeds, fixed_seed, rd_seed);
+        generate_animation_files(frames, N_seeds, fixed_seed, rd_seed, output_format, compress, incremental, n_threads, snapshot_bits, step_size);
 
         // Create a named std::string
-        string commandString = "python3 ../visualisation.py -program 2 -num_frames " + to_string(frames) + " -fps " + to_string(fps);
+        string commandString = "python3 ../visualisation.py -program 2 -num_frames " + to_string(frames) + " -fps " + to_string(fps) + " -format " + to_string(output_format);
 
         // Use c_str() on the named string
         const char* command = commandString.c_str();
@@ -715,10 +1326,10 @@ int main (int argc, char *argv[]) {
     // grid generation animation
     if (run_option == 3) {
 
-        animate_algorithm(N_seeds, rd_seed, algorithm, sort, sort_scheme);
+        animate_algorithm(N_seeds, rd_seed, algorithm, sort, sort_scheme, output_format, snapshot_bits);
 
         // Create a named std::string
-        string commandString = "python3 ../visualisation.py -program 3 -num_frames " + to_string(N_seeds) + " -fps " + to_string(fps);
+        string commandString = "python3 ../visualisation.py -program 3 -num_frames " + to_string(N_seeds) + " -fps " + to_string(fps) + " -format " + to_string(output_format);
 
         // Use c_str() on the named string
         const char* command = commandString.c_str();
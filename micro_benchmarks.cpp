@@ -0,0 +1,465 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+#include <sys/stat.h>
+#include "Point.h"
+#include "Halfplane.h"
+#include "HalfplaneBatch.h"
+#include "VoronoiCell.h"
+#include "VoronoiMesh.h"
+#include "SpaceFillingCurve.h"
+#include "RobustPredicates.h"
+using namespace std;
+
+// micro benchmarks of the geometric hot paths, see the "Micro benchmarks" section of the README
+
+#define RED_TEXT "\033[1;31m"
+#define RESET_COLOR "\033[0m"
+#define GREEN_TEXT "\033[1;32m"
+
+struct BenchmarkResult {
+    string name;
+    long long items;            // kernel calls (or cells) per repetition
+    int repetitions;
+    double min_ns;              // per item
+    double median_ns;
+    double mean_ns;
+};
+
+struct BenchmarkSettings {
+    int N_seeds = 100000;
+    int warmup = 2;
+    int repetitions = 10;
+    int rd_seed = 42;
+    string filter = "";
+    string csv_file = "benchmarks/micro_benchmarks.csv";
+    string json_file = "benchmarks/micro_benchmarks.json";
+};
+
+// keeps the compiler from dropping the benchmarked calls
+volatile double sink = 0;
+
+double elapsed_ns(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+// per item statistics of the timed repetitions (total ns of each repetition in samples)
+BenchmarkResult summarize(string name, long long items, vector<double> samples) {
+
+    sort(samples.begin(), samples.end());
+
+    double sum = 0;
+    for (int i = 0; i < samples.size(); i++) {
+        sum += samples[i];
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.items = items;
+    result.repetitions = samples.size();
+    result.min_ns = samples.front() / items;
+    result.median_ns = samples[samples.size() / 2] / items;
+    result.mean_ns = sum / samples.size() / items;
+
+    return result;
+}
+
+bool selected(const BenchmarkSettings &settings, string name) {
+    return settings.filter.empty() || name.find(settings.filter) != string::npos;
+}
+
+// run body warmup + repetitions times and time every run, body handles items items per run
+template <class F>
+void run_benchmark(const BenchmarkSettings &settings, vector<BenchmarkResult> &results, string name, long long items, F body) {
+
+    if (!selected(settings, name)) {
+        return;
+    }
+
+    for (int r = 0; r < settings.warmup; r++) {
+        body();
+    }
+
+    vector<double> samples;
+    for (int r = 0; r < settings.repetitions; r++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        body();
+        samples.push_back(elapsed_ns(start));
+    }
+
+    results.push_back(summarize(name, items, samples));
+    cout << left << setw(30) << name << right << setw(12) << fixed << setprecision(1) << results.back().median_ns << " ns  (min "
+         << results.back().min_ns << ", " << items << " items x " << settings.repetitions << ")" << endl;
+}
+
+// uniform random points in the unit square, sorted along the hilbert curve like -sort_option 4
+vector<Point> generate_points(int N, int rd_seed) {
+
+    mt19937_64 eng(rd_seed);
+    uniform_real_distribution<double> distr(0, 1);
+
+    vector<Point> points(N);
+    vector<uint64_t> keys(N);
+    for (int i = 0; i < N; i++) {
+        double x = distr(eng);
+        double y = distr(eng);
+        points[i] = Point(x, y);
+        keys[i] = get_hilbert_key(points[i]);
+    }
+
+    vector<int> order = radix_sort_keys(keys);
+    vector<Point> sorted_pts(N);
+    for (int i = 0; i < N; i++) {
+        sorted_pts[i] = points[order[i]];
+    }
+
+    return sorted_pts;
+}
+
+// random query points that are not seeds (same generator, other seed)
+vector<Point> generate_queries(int N, int rd_seed) {
+
+    mt19937_64 eng(rd_seed + 1);
+    uniform_real_distribution<double> distr(0.001, 0.999);
+
+    vector<Point> points(N);
+    for (int i = 0; i < N; i++) {
+        double x = distr(eng);
+        double y = distr(eng);
+        points[i] = Point(x, y);
+    }
+
+    return points;
+}
+
+void rebuild_hint_grid(VoronoiMesh &vmesh) {
+    vmesh.hint_grid = HintGrid(vmesh.pts.size());
+    for (int i = 0; i < vmesh.pts.size(); i++) {
+        vmesh.hint_grid.add_point(vmesh.pts[i], i);
+    }
+}
+
+// halfplanes between random seed pairs, never parallel in practice
+vector<Halfplane> generate_halfplanes(int N, const vector<Point> &pts) {
+
+    mt19937_64 eng(7);
+    uniform_int_distribution<int> distr(0, pts.size() - 1);
+
+    vector<Halfplane> halfplanes;
+    for (int i = 0; i < N; i++) {
+        int a = distr(eng);
+        int b = distr(eng);
+        if (a == b) {
+            b = (b + 1) % pts.size();
+        }
+        halfplanes.push_back(Halfplane(pts[a], pts[b], a, b));
+    }
+
+    return halfplanes;
+}
+
+void bench_intersections(const BenchmarkSettings &settings, const vector<Point> &pts, vector<BenchmarkResult> &results) {
+
+    const int nr_pairs = 4096;
+    vector<Halfplane> halfplanes = generate_halfplanes(nr_pairs, pts);
+    VoronoiCell cell;
+    vector<intersection> intersections;
+    intersections.reserve(nr_pairs);
+
+    run_benchmark(settings, results, "intersect_two_halfplanes", nr_pairs, [&]() {
+        intersections.clear();
+        for (int i = 0; i < nr_pairs; i++) {
+            cell.intersect_two_halfplanes(halfplanes[i], halfplanes[(i * 7 + 1) % nr_pairs], intersections);
+        }
+        sink = sink + intersections.size();
+    });
+
+    // one halfplane against a whole batch, as in construct_cell (batch of the local seeds)
+    int batch_sizes[] = {8, 64};
+    for (int b = 0; b < 2; b++) {
+
+        int batch_size = batch_sizes[b];
+        const int nr_queries = 1024;
+        HalfplaneBatch batch;
+        batch.assign(halfplanes.data(), batch_size);
+
+        run_benchmark(settings, results, "halfplane_batch_" + to_string(batch_size), nr_queries, [&]() {
+            for (int i = 0; i < nr_queries; i++) {
+                const Halfplane &hp = halfplanes[batch_size + i];
+                batch_intersection closest = batch.find_smallest_pos_intersect(hp, 0, 0, 42, hp.index2, -42);
+                sink = sink + closest.rel_dist;
+            }
+        });
+    }
+
+    // incircle predicate of the point insertion: random seeds are decided by the floating point filter, four
+    // seeds on a circle of a grid need the exact evaluation
+    const int nr_predicates = 4096;
+    vector<PredicateSite> sites;
+    for (int i = 0; i < nr_predicates + 3; i++) {
+        sites.push_back(make_site(pts[i % pts.size()], i));
+    }
+    run_benchmark(settings, results, "incircle_filtered", nr_predicates, [&]() {
+        for (int i = 0; i < nr_predicates; i++) {
+            sink = sink + incircle_sign_perturbed(sites[i], sites[i + 1], sites[i + 2], sites[i + 3]);
+        }
+    });
+
+    vector<PredicateSite> grid_sites;
+    for (int i = 0; i < nr_predicates; i++) {
+        Point corner((i % 64) / 64.0, (i / 64) / 64.0);
+        grid_sites.push_back(make_site(corner, 4*i));
+        grid_sites.push_back(make_site(Point(corner.x + 1/64.0, corner.y), 4*i + 1));
+        grid_sites.push_back(make_site(Point(corner.x + 1/64.0, corner.y + 1/64.0), 4*i + 2));
+        grid_sites.push_back(make_site(Point(corner.x, corner.y + 1/64.0), 4*i + 3));
+    }
+    run_benchmark(settings, results, "incircle_exact", nr_predicates, [&]() {
+        for (int i = 0; i < nr_predicates; i++) {
+            sink = sink + incircle_sign_perturbed(grid_sites[4*i], grid_sites[4*i + 1], grid_sites[4*i + 2], grid_sites[4*i + 3]);
+        }
+    });
+}
+
+void bench_mesh_kernels(const BenchmarkSettings &settings, VoronoiMesh &vmesh, vector<BenchmarkResult> &results) {
+
+    const int nr_queries = 10000;
+    vector<Point> queries = generate_queries(nr_queries, settings.rd_seed);
+
+    // walks from the hint grid, as during the insertion
+    rebuild_hint_grid(vmesh);
+    run_benchmark(settings, results, "find_cell_index", nr_queries, [&]() {
+        for (int i = 0; i < nr_queries; i++) {
+            sink = sink + vmesh.find_cell_index(queries[i]);
+        }
+    });
+
+    // tracing a new cell around each query point (the cells of the mesh are not changed)
+    vector<int> start_cells;
+    for (int i = 0; i < nr_queries; i++) {
+        start_cells.push_back(vmesh.find_cell_index(queries[i]));
+    }
+    run_benchmark(settings, results, "trace_new_cell", nr_queries, [&]() {
+        for (int i = 0; i < nr_queries; i++) {
+            vmesh.trace_new_cell(queries[i], vmesh.pts.size(), start_cells[i]);
+        }
+    });
+    vmesh.hint_grid = HintGrid();
+}
+
+// the last seeds are inserted into a copy of the mesh built from all the others, every phase of insert_cell is timed
+void bench_insert_phases(const BenchmarkSettings &settings, const vector<Point> &pts, vector<BenchmarkResult> &results) {
+
+    if (!selected(settings, "insert_cell")) {
+        return;
+    }
+
+    int nr_inserts = min(10000, static_cast<int>(pts.size()) / 2);
+    int nr_base = pts.size() - nr_inserts;
+
+    VoronoiMesh base_mesh(vector<Point>(pts.begin(), pts.begin() + nr_base));
+    base_mesh.print_progress = false;
+    base_mesh.do_point_insertion();
+    rebuild_hint_grid(base_mesh);
+
+    vector<double> find_samples;
+    vector<double> trace_samples;
+    vector<double> clip_samples;
+
+    for (int r = 0; r < settings.warmup + settings.repetitions; r++) {
+
+        VoronoiMesh vmesh = base_mesh;
+        double find_ns = 0;
+        double trace_ns = 0;
+        double clip_ns = 0;
+
+        for (int i = nr_base; i < pts.size(); i++) {
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            int cell_index = vmesh.find_cell_index(pts[i]);
+            find_ns += elapsed_ns(start);
+
+            start = chrono::steady_clock::now();
+            vmesh.trace_new_cell(pts[i], i, cell_index);
+            trace_ns += elapsed_ns(start);
+
+            start = chrono::steady_clock::now();
+            vmesh.add_traced_cell();
+            clip_ns += elapsed_ns(start);
+
+            vmesh.hint_grid.add_point(pts[i], i);
+        }
+
+        if (r >= settings.warmup) {
+            find_samples.push_back(find_ns);
+            trace_samples.push_back(trace_ns);
+            clip_samples.push_back(clip_ns);
+        }
+    }
+
+    string names[] = {"insert_cell_find", "insert_cell_trace", "insert_cell_clip"};
+    vector<double> *samples[] = {&find_samples, &trace_samples, &clip_samples};
+    for (int k = 0; k < 3; k++) {
+        if (selected(settings, names[k])) {
+            results.push_back(summarize(names[k], nr_inserts, *samples[k]));
+            cout << left << setw(30) << names[k] << right << setw(12) << fixed << setprecision(1) << results.back().median_ns << " ns  (min "
+                 << results.back().min_ns << ", " << nr_inserts << " items x " << settings.repetitions << ")" << endl;
+        }
+    }
+}
+
+void bench_output(const BenchmarkSettings &settings, VoronoiMesh &vmesh, vector<BenchmarkResult> &results) {
+
+    // written as frame 999 into files/, the files are removed afterwards
+    run_benchmark(settings, results, "save_mesh_to_files", vmesh.vcells.size(), [&]() {
+        vmesh.save_mesh_to_files(999);
+    });
+    run_benchmark(settings, results, "save_mesh_to_binary", vmesh.vcells.size(), [&]() {
+        vmesh.save_mesh_to_binary(999);
+    });
+
+    remove("files/seed_list999.csv");
+    remove("files/vertex_list999.csv");
+    remove("files/edge_list999.csv");
+    remove("files/mesh999.vmsh");
+}
+
+void write_csv(string filename, const vector<BenchmarkResult> &results) {
+
+    ofstream file(filename);
+    file << "name,items,repetitions,min_ns_per_item,median_ns_per_item,mean_ns_per_item\n";
+    for (int i = 0; i < results.size(); i++) {
+        file << results[i].name << "," << results[i].items << "," << results[i].repetitions << "," << results[i].min_ns << ","
+             << results[i].median_ns << "," << results[i].mean_ns << "\n";
+    }
+}
+
+void write_json(string filename, const BenchmarkSettings &settings, const vector<BenchmarkResult> &results) {
+
+    ofstream file(filename);
+    file << "{\n";
+    file << "  \"nr_seeds\": " << settings.N_seeds << ",\n";
+    file << "  \"random_seed\": " << settings.rd_seed << ",\n";
+    file << "  \"warmup\": " << settings.warmup << ",\n";
+    file << "  \"intersection_kernel\": \"" << HalfplaneBatch::get_kernel_name() << "\",\n";
+    file << "  \"benchmarks\": [\n";
+    for (int i = 0; i < results.size(); i++) {
+        file << "    {\"name\": \"" << results[i].name << "\", \"items\": " << results[i].items << ", \"repetitions\": " << results[i].repetitions
+             << ", \"min_ns_per_item\": " << results[i].min_ns << ", \"median_ns_per_item\": " << results[i].median_ns
+             << ", \"mean_ns_per_item\": " << results[i].mean_ns << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+}
+
+bool is_integer(const char *str) {
+    if (*str == '-' || *str == '+') {
+        str++;
+    }
+    if (*str == '\0') {
+        return false;
+    }
+    for (; *str != '\0'; str++) {
+        if (*str < '0' || *str > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+
+    // output directories (already existing ones are fine)
+    mkdir("files", 0755);
+    mkdir("benchmarks", 0755);
+
+    BenchmarkSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+
+        // options with an integer value
+        const char *int_options[] = {"-n", "-reps", "-warmup", "-fixed_seed"};
+        int *int_values[] = {&settings.N_seeds, &settings.repetitions, &settings.warmup, &settings.rd_seed};
+        bool found_command = false;
+
+        for (int k = 0; k < 4; k++) {
+            if (strcmp(argv[i], int_options[k]) == 0) {
+                found_command = true;
+                if (argc > i+1 && is_integer(argv[i+1])) {
+                    *int_values[k] = stoi(argv[i+1]);
+                    cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << argv[i] << " = " << argv[i+1] << endl;
+                    i++;
+                } else {
+                    cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << argv[i] << " needs an integer value" << endl;
+                    return 1;
+                }
+            }
+        }
+
+        // options with a string value
+        const char *string_options[] = {"-filter", "-csv", "-json"};
+        string *string_values[] = {&settings.filter, &settings.csv_file, &settings.json_file};
+
+        for (int k = 0; k < 3; k++) {
+            if (!found_command && strcmp(argv[i], string_options[k]) == 0) {
+                found_command = true;
+                if (argc > i+1) {
+                    *string_values[k] = argv[i+1];
+                    cout << GREEN_TEXT << "CLI OPTION: " << RESET_COLOR << argv[i] << " = " << argv[i+1] << endl;
+                    i++;
+                } else {
+                    cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << argv[i] << " needs a value" << endl;
+                    return 1;
+                }
+            }
+        }
+
+        if (!found_command && (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "--help") == 0)) {
+            cout << "vmp_bench - micro benchmarks of the voronoi mesh kernels" << endl << endl;
+            cout << "-n                 : number of seedpoints of the benchmark mesh (standard: 100000)" << endl;
+            cout << "-reps              : timed repetitions per benchmark (standard: 10)" << endl;
+            cout << "-warmup            : untimed repetitions before (standard: 2)" << endl;
+            cout << "-fixed_seed        : random seed of the inputs (standard: 42)" << endl;
+            cout << "-filter            : only run benchmarks whose name contains this string" << endl;
+            cout << "-csv               : csv output file (standard: benchmarks/micro_benchmarks.csv)" << endl;
+            cout << "-json              : json output file (standard: benchmarks/micro_benchmarks.json)" << endl;
+            cout << "-h, -help, --help  : show this window and exit" << endl;
+            return 0;
+        } else if (!found_command) {
+            cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "Unknown command found: " << argv[i] << " <- please remove or correct!" << endl;
+            return 1;
+        }
+    }
+
+    if (settings.N_seeds < 100 || settings.repetitions < 1 || settings.warmup < 0) {
+        cout << RED_TEXT << "CLI ERROR: " << RESET_COLOR << "need at least 100 seeds and 1 repetition" << endl;
+        return 1;
+    }
+
+    cout << "intersection kernel: " << HalfplaneBatch::get_kernel_name() << endl;
+    cout << "building benchmark mesh with " << settings.N_seeds << " seeds..." << endl;
+
+    vector<Point> pts = generate_points(settings.N_seeds, settings.rd_seed);
+    VoronoiMesh vmesh(pts);
+    vmesh.print_progress = false;
+    vmesh.do_point_insertion();
+
+    vector<BenchmarkResult> results;
+    bench_intersections(settings, pts, results);
+    bench_mesh_kernels(settings, vmesh, results);
+    bench_insert_phases(settings, pts, results);
+    bench_output(settings, vmesh, results);
+
+    write_csv(settings.csv_file, results);
+    write_json(settings.json_file, settings, results);
+    cout << "results written to " << settings.csv_file << " and " << settings.json_file << endl;
+
+    return 0;
+}
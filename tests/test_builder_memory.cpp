@@ -0,0 +1,56 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include "VoronoiBuilder.h"
+#include "CellPool.h"
+using namespace std;
+
+// a builder reused for many timesteps on several threads must not keep more and more cell pool slabs
+int main() {
+
+    const int n = 20000;
+    const int nr_builds = 30;
+    int algorithms[3] = {0, 1, 4};
+
+    mt19937 rng(42);
+    uniform_real_distribution<double> dist(0, 1);
+    vector<double> xy(2 * n);
+
+    bool passed = true;
+    for (int a = 0; a < 3; a++) {
+
+        VoronoiBuilder builder(algorithms[a], 4);
+        long long reserved_after_warmup = 0;
+        long long max_reserved = 0;
+        for (int b = 0; b < nr_builds; b++) {
+
+            for (int i = 0; i < 2 * n; i++) {
+                xy[i] = dist(rng);
+            }
+            builder.build(xy.data(), n);
+            if (builder.get_nr_cells() != n) {
+                cout << "algorithm " << algorithms[a] << ": build " << b << " has " << builder.get_nr_cells() << " cells" << endl;
+                passed = false;
+            }
+
+            long long reserved = CellPool::get_reserved_bytes();
+            if (b == 2) {
+                reserved_after_warmup = reserved;
+            }
+            if (reserved > max_reserved) {
+                max_reserved = reserved;
+            }
+        }
+
+        // some slack for the random seeds, a leak adds several MB per build
+        long long limit = reserved_after_warmup + reserved_after_warmup / 4 + 4 * CellPool::slab_size;
+        cout << "algorithm " << algorithms[a] << ": " << reserved_after_warmup / 1024.0 / 1024.0 << " MB after 3 builds, at most "
+             << max_reserved / 1024.0 / 1024.0 << " MB in " << nr_builds << " builds" << endl;
+        if (max_reserved > limit) {
+            cout << "algorithm " << algorithms[a] << ": cell pool keeps growing" << endl;
+            passed = false;
+        }
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+#include "VoronoiBuilder.h"
+#include "CompactMesh.h"
+#include "MappedMesh.h"
+using namespace std;
+
+// a binary mesh file read back through MappedMesh has to give the arrays that were saved, truncated or corrupted
+// files have to be rejected by open
+bool passed = true;
+
+void expect(bool condition, const string &what) {
+    if (!condition) {
+        cout << "failed: " << what << endl;
+        passed = false;
+    }
+}
+
+void write_file(const string &name, const vector<char> &content) {
+    ofstream file(name, ios::binary);
+    file.write(content.data(), content.size());
+}
+
+int main() {
+
+    const int n = 2000;
+    mt19937 rng(7);
+    uniform_real_distribution<double> dist(0, 1);
+    vector<double> xy(2 * n);
+    for (int i = 0; i < 2 * n; i++) {
+        xy[i] = dist(rng);
+    }
+
+    VoronoiBuilder builder(1, 1);
+    builder.build(xy.data(), n);
+    CompactMesh cmesh(builder.get_voronoi_mesh());
+
+    const string name = "test_mapped_mesh.vmsh";
+    expect(cmesh.save_mesh_to_binary(name), "save_mesh_to_binary");
+
+    // round trip
+    MappedMesh mapped;
+    expect(mapped.open(name), "open a saved mesh");
+    if (mapped.header != nullptr) {
+        expect(mapped.header->nr_cells == cmesh.seeds.size(), "number of cells");
+        expect(mapped.header->nr_vertices == cmesh.vertices.size(), "number of vertices");
+        expect(mapped.header->nr_cell_entries == cmesh.cell_vertices.size(), "number of cell entries");
+        for (int i = 0; i < cmesh.seeds.size(); i++) {
+            expect(mapped.seeds[i].x == cmesh.seeds[i].x && mapped.seeds[i].y == cmesh.seeds[i].y, "seed " + to_string(i));
+        }
+        for (int i = 0; i < cmesh.vertices.size(); i++) {
+            expect(mapped.vertices[i].x == cmesh.vertices[i].x && mapped.vertices[i].y == cmesh.vertices[i].y, "vertex " + to_string(i));
+        }
+        for (int i = 0; i < cmesh.cell_offsets.size(); i++) {
+            expect(mapped.get_offset(i) == cmesh.cell_offsets[i], "cell offset " + to_string(i));
+        }
+        for (int i = 0; i < cmesh.cell_vertices.size(); i++) {
+            expect(mapped.get_vertex(i) == cmesh.cell_vertices[i], "cell vertex " + to_string(i));
+            expect(mapped.get_neighbour(i) == cmesh.cell_neighbours[i], "cell neighbour " + to_string(i));
+        }
+    }
+    mapped.close();
+
+    ifstream file(name, ios::binary);
+    vector<char> content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    file.close();
+
+    // truncated files, from an empty one to one missing the last byte
+    const string broken = "test_mapped_mesh_broken.vmsh";
+    size_t lengths[6] = {0, 16, sizeof(BinaryMeshHeader), content.size() / 2, content.size() - 8, content.size() - 1};
+    for (int i = 0; i < 6; i++) {
+        write_file(broken, vector<char>(content.begin(), content.begin() + lengths[i]));
+        expect(!mapped.open(broken), "reject a file truncated to " + to_string(lengths[i]) + " bytes");
+    }
+
+    // corrupted headers
+    BinaryMeshHeader header;
+    memcpy(&header, content.data(), sizeof(header));
+    vector<BinaryMeshHeader> corrupted(6, header);
+    corrupted[0].magic[0] = 'X';
+    corrupted[1].version = BINARY_MESH_VERSION + 1;
+    corrupted[2].index_size = 2;
+    corrupted[3].nr_cells = UINT64_MAX / 8;
+    corrupted[4].nr_cell_entries += 1;
+    corrupted[5].vertices_offset += 4;
+    for (int i = 0; i < corrupted.size(); i++) {
+        vector<char> modified = content;
+        memcpy(modified.data(), &corrupted[i], sizeof(header));
+        write_file(broken, modified);
+        expect(!mapped.open(broken), "reject corrupted header " + to_string(i));
+    }
+
+    remove(name.c_str());
+    remove(broken.c_str());
+
+    if (passed) {
+        cout << "binary mesh of " << n << " cells read back, " << 6 + corrupted.size() << " broken files rejected" << endl;
+    }
+    return passed ? 0 : 1;
+}
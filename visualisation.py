@@ -1,5 +1,6 @@
 # import packages
 import argparse
+import os
 import time
 from tqdm import tqdm
 import matplotlib.pyplot as plt
@@ -10,8 +11,52 @@ from scipy.optimize import curve_fit
 
 
 
+# LOAD MESH : --------------------------------------------------------------------------------------------------
+def load_mesh(nr, fmt):
+
+    # csv files: seed, vertex and edge lists (gzip compressed files are read transparently)
+    if (fmt == 0):
+        def csv_file(name):
+            return name + '.csv' if os.path.exists(name + '.csv') else name + '.csv.gz'
+
+        seeds = np.loadtxt(csv_file(f'files/seed_list{nr}'), delimiter=',', skiprows=1, ndmin=2)
+        verticies = np.loadtxt(csv_file(f'files/vertex_list{nr}'), delimiter=',', skiprows=1, ndmin=2)
+        edges = np.loadtxt(csv_file(f'files/edge_list{nr}'), delimiter=',', skiprows=1, ndmin=2)
+        return seeds, verticies, edges
+
+    # binary mesh file (layout see MappedMesh.h), the arrays are mapped and not parsed
+    filename = f'files/mesh{nr}.vmsh'
+    header_type = np.dtype([('magic', 'S8'), ('version', '<u4'), ('index_size', '<u4'),
+                            ('nr_cells', '<u8'), ('nr_vertices', '<u8'), ('nr_cell_entries', '<u8'),
+                            ('seeds_offset', '<u8'), ('vertices_offset', '<u8'), ('cell_offsets_offset', '<u8'),
+                            ('cell_vertices_offset', '<u8'), ('cell_neighbours_offset', '<u8')])
+    header = np.memmap(filename, dtype=header_type, mode='r', shape=(1,))[0]
+    if (header['magic'] != b'VMPMESH' or header['version'] != 1):
+        raise ValueError(filename + ' is not a valid mesh file')
+
+    index_type = '<i4' if header['index_size'] == 4 else '<i8'
+    n_cells = int(header['nr_cells'])
+    n_entries = int(header['nr_cell_entries'])
+
+    seeds = np.memmap(filename, dtype='<f8', mode='r', offset=int(header['seeds_offset']), shape=(n_cells, 2))
+    verticies = np.memmap(filename, dtype='<f8', mode='r', offset=int(header['vertices_offset']), shape=(int(header['nr_vertices']), 2))
+    cell_offsets = np.memmap(filename, dtype=index_type, mode='r', offset=int(header['cell_offsets_offset']), shape=(n_cells + 1,))
+    cell_vertices = np.memmap(filename, dtype=index_type, mode='r', offset=int(header['cell_vertices_offset']), shape=(n_entries,))
+    cell_neighbours = np.memmap(filename, dtype=index_type, mode='r', offset=int(header['cell_neighbours_offset']), shape=(n_entries,))
+
+    # edge j of a cell runs from vertex j-1 to vertex j, every inner edge is kept only once (from the smaller cell)
+    cell_ids = np.repeat(np.arange(n_cells), np.diff(cell_offsets))
+    previous = np.arange(n_entries) - 1
+    previous[cell_offsets[:-1]] = cell_offsets[1:] - 1
+    keep = (cell_neighbours < 0) | (cell_ids < cell_neighbours)
+    edges = np.hstack((verticies[cell_vertices[previous[keep]]], verticies[cell_vertices[keep]]))
+
+    return seeds, verticies, edges
+
+
+
 # SHOW IMAGE : --------------------------------------------------------------------------------------------------
-def show_image():
+def show_image(fmt):
 
     # function to plot an edge
     def plot_edge(edge):
@@ -19,9 +64,7 @@ def show_image():
 
     # load files for first snapshot
     nr = 0
-    seeds = np.loadtxt('files/seed_list' + str(nr) +  '.csv', delimiter=',', skiprows=1)
-    verticies = np.loadtxt('files/vertex_list' + str(nr) +  '.csv', delimiter=',', skiprows=1)
-    edges = np.loadtxt('files/edge_list' + str(nr) +  '.csv', delimiter=',', skiprows=1)
+    seeds, verticies, edges = load_mesh(nr, fmt)
 
     # optional style settings
     #plt.style.use('dark_background')
@@ -109,10 +152,23 @@ def benchmark():
     plt.savefig("../figures/memory_benchmark.png")
     plt.show()
 
+    # optional: thread scaling benchmark
+    if os.path.exists('benchmarks/threads_benchmark.csv'):
+        threads = np.loadtxt('benchmarks/threads_benchmark.csv', delimiter=',', skiprows=1, ndmin=2)
+
+        plt.title('thread scaling benchmark')
+        plt.xlabel('number of threads')
+        plt.ylabel('speedup')
+        plt.plot(threads[:, 0], threads[:, 2], label = 'measured speedup', marker = '+')
+        plt.plot(threads[:, 0], threads[:, 0], label = 'ideal speedup', color='grey', linestyle = '--')
+        plt.legend(loc = 'best')
+        plt.savefig("../figures/threads_benchmark.png")
+        plt.show()
+
 
 
 # MOVING MESH ANIMATION : ----------------------------------------------------------------------------
-def mm_anim(num_frames, frames_per_second):
+def mm_anim(num_frames, frames_per_second, fmt):
     print("num frames:", num_frames, "fps", frames_per_second)
 
         # function to plot an edge
@@ -126,9 +182,7 @@ def mm_anim(num_frames, frames_per_second):
         plt.clf()
     
         # load data from the current file
-        seeds = np.loadtxt(f'files/seed_list{frame}.csv', delimiter=',', skiprows=1)
-        verticies = np.loadtxt(f'files/vertex_list{frame}.csv', delimiter=',', skiprows=1)
-        edges = np.loadtxt(f'files/edge_list{frame}.csv', delimiter=',', skiprows=1)
+        seeds, verticies, edges = load_mesh(frame, fmt)
 
         # plot edges
         for edge in edges:
@@ -162,7 +216,7 @@ def mm_anim(num_frames, frames_per_second):
 
 
 # GRID GENERATION ANIMATION : ----------------------------------------------------------------------------
-def gg_anim(num_frames, frames_per_second):
+def gg_anim(num_frames, frames_per_second, fmt):
     
     # function to plot an edge
     def plot_edge(ax, edge):
@@ -178,9 +232,7 @@ def gg_anim(num_frames, frames_per_second):
         plt.ylim(0,1)
 
         # load data from the current file
-        seeds = np.loadtxt(f'files/seed_list{frame+1}.csv', delimiter=',', skiprows=1)
-        verticies = np.loadtxt(f'files/vertex_list{frame+1}.csv', delimiter=',', skiprows=1)
-        edges = np.loadtxt(f'files/edge_list{frame+1}.csv', delimiter=',', skiprows=1)
+        seeds, verticies, edges = load_mesh(frame+1, fmt)
 
         #seeds_end = np.loadtxt(f'build/files/seed_list98.csv', delimiter=',', skiprows=1)
         #plt.scatter(seeds_end[:, 0], seeds_end[:, 1], s=25, zorder = 2)
@@ -190,10 +242,7 @@ def gg_anim(num_frames, frames_per_second):
             plot_edge(plt.gca(), edge)
     
         # optional : scatter seeds and verticies
-        if frame == 0:
-            plt.scatter(seeds[0], seeds[1], s = 25, zorder = 2)
-        else:
-            plt.scatter(seeds[:, 0], seeds[:, 1], s=25, zorder=2)
+        plt.scatter(seeds[:, 0], seeds[:, 1], s=25, zorder=2)
         #plt.scatter(verticies[:, 0], verticies[:, 1], s=10, zorder=3)
 
 
@@ -226,6 +275,7 @@ def main():
     parser.add_argument('-program', type=int, help='which visualisation to run (0: show image, 1: benchmark, 2: moving mesh animation, 3: grid generation animation)')
     parser.add_argument('-num_frames', type=int, help='number of frames for the animations')
     parser.add_argument('-fps', type=int, help='fps for the animations')
+    parser.add_argument('-format', type=int, default=0, help='format of the mesh files (0: csv, 1: binary)')
 
     args = parser.parse_args()
 
@@ -233,17 +283,18 @@ def main():
     program = args.program
     num_frames = args.num_frames
     fps = args.fps
+    fmt = args.format
 
     # start the specified program
     print("starting python visualisation...")
     if (program == 0):
-        show_image()
+        show_image(fmt)
     elif (program == 1):
         benchmark()
     elif (program == 2):
-        mm_anim(num_frames, fps)
+        mm_anim(num_frames, fps, fmt)
     elif (program == 3):
-        gg_anim(num_frames, fps)
+        gg_anim(num_frames, fps, fmt)
 
 if __name__ == '__main__':
     main()
\ No newline at end of file